@@ -0,0 +1,179 @@
+#include "hash_map.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// Key distributions known to hurt MaskRangeHashing combined with the identity std::hash of integers,
+// run against every collision policy and range hash. Besides time, every benchmark reports the
+// average probe length of hits, the expected probe length of misses and the longest cluster
+// of the built table, so a degenerate configuration is visible even when it is still fast.
+
+namespace {
+
+using Key = std::uint64_t;
+using Value = std::uint64_t;
+
+template <class CollisionPolicy, class RangeHash>
+using Map = HashMap<Key, Value, CollisionPolicy, std::hash<Key>, std::equal_to<Key>, RangeHash>;
+
+using Pattern = Key (*)(std::uint64_t i);
+
+Key sequential(const std::uint64_t i)
+{
+    return i;
+}
+
+Key stride_64(const std::uint64_t i)
+{
+    return i * 64;
+}
+
+// page aligned keys
+Key stride_4096(const std::uint64_t i)
+{
+    return i * 4096;
+}
+
+// addresses of 16-byte aligned heap objects
+Key aligned_pointer(const std::uint64_t i)
+{
+    return 0x00007f3a5c000000ULL + i * 16;
+}
+
+// distinct high bits over a common low half-word
+Key shared_low_bits(const std::uint64_t i)
+{
+    return ((i * 0x9e3779b97f4a7c15ULL) << 16) | 0xbeef;
+}
+
+// every key is zero modulo any practical table size
+Key flooding(const std::uint64_t i)
+{
+    return (i + 1) << 40;
+}
+
+// keys to insert in a shuffled order and keys of the same pattern which are absent
+std::pair<std::vector<Key>, std::vector<Key>> make_keys(const Pattern pattern, const std::size_t count)
+{
+    std::pair<std::vector<Key>, std::vector<Key>> result;
+    for (std::size_t i = 0; i < count; ++i) {
+        result.first.push_back(pattern(i));
+        result.second.push_back(pattern(count + i));
+    }
+    std::shuffle(result.first.begin(), result.first.end(), std::mt19937_64{1});
+    return result;
+}
+
+template <class Map>
+Map build(const std::vector<Key> & keys)
+{
+    Map map;
+    for (const Key key : keys) {
+        map.try_emplace(key, key);
+    }
+    return map;
+}
+
+template <class Map>
+void report_shape(benchmark::State & state, const Map & map)
+{
+    const TableStats stats = map.stats();
+    state.counters["hit_probes"] = stats.average_probe_length;
+    state.counters["miss_probes"] = stats.expected_miss_length;
+    state.counters["longest_cluster"] = static_cast<double>(stats.longest_cluster);
+}
+
+template <class Map>
+void bm_insert(benchmark::State & state, const Pattern pattern)
+{
+    const auto keys = make_keys(pattern, state.range(0)).first;
+    for (auto _ : state) {
+        Map map;
+        for (const Key key : keys) {
+            map.try_emplace(key, key);
+        }
+        benchmark::DoNotOptimize(map);
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+    report_shape(state, build<Map>(keys));
+}
+
+template <class Map>
+void bm_find_hit(benchmark::State & state, const Pattern pattern)
+{
+    const auto keys = make_keys(pattern, state.range(0)).first;
+    const Map map = build<Map>(keys);
+    for (auto _ : state) {
+        for (const Key key : keys) {
+            benchmark::DoNotOptimize(map.find(key));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+    report_shape(state, map);
+}
+
+template <class Map>
+void bm_find_miss(benchmark::State & state, const Pattern pattern)
+{
+    const auto [keys, missing] = make_keys(pattern, state.range(0));
+    const Map map = build<Map>(keys);
+    for (auto _ : state) {
+        for (const Key key : missing) {
+            benchmark::DoNotOptimize(map.find(key));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * missing.size());
+    report_shape(state, map);
+}
+
+template <class Map>
+void register_map(const std::string & name)
+{
+    struct NamedPattern
+    {
+        const char * name;
+        Pattern pattern;
+        std::int64_t max_size;
+    };
+    // flooding is quadratic by construction, so it is kept small enough to finish
+    const NamedPattern patterns[] = {
+            {"sequential", sequential, 1 << 20},
+            {"stride_64", stride_64, 1 << 20},
+            {"stride_4096", stride_4096, 1 << 16},
+            {"aligned_pointer", aligned_pointer, 1 << 20},
+            {"shared_low_bits", shared_low_bits, 1 << 16},
+            {"flooding", flooding, 1 << 12},
+    };
+    for (const NamedPattern & p : patterns) {
+        const auto add = [&](const std::string & operation, void (*fn)(benchmark::State &, Pattern)) {
+            benchmark::RegisterBenchmark((name + "/" + p.name + "/" + operation).c_str(), fn, p.pattern)
+                    ->RangeMultiplier(16)
+                    ->Range(1 << 8, p.max_size);
+        };
+        add("insert", bm_insert<Map>);
+        add("find_hit", bm_find_hit<Map>);
+        add("find_miss", bm_find_miss<Map>);
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    register_map<Map<LinearProbing, MaskRangeHashing>>("linear_mask");
+    register_map<Map<QuadraticProbing, MaskRangeHashing>>("quadratic_mask");
+    register_map<Map<LinearProbing, FibonacciRangeHashing>>("linear_fibonacci");
+    register_map<Map<QuadraticProbing, FibonacciRangeHashing>>("quadratic_fibonacci");
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+}
@@ -0,0 +1,90 @@
+#include "hash_aggregator.h"
+#include "hash_functions.h"
+#include "hash_map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Group-by with count, sum, min and max of a value column: `operator[]` of a HashMap per row
+// against HashAggregator batches, on one and on all hardware threads, for several numbers of groups.
+// usage: aggregation_bench [rows = 20000000]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Totals
+{
+    std::uint64_t count = 0;
+    double sum = 0;
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+};
+
+void report(const std::string & name, const Clock::duration duration, const std::size_t rows, const std::size_t groups)
+{
+    std::cout << std::left << std::setw(26) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(12) << 1e9 * std::chrono::duration<double>(duration).count() / rows
+              << std::setw(12) << groups << '\n';
+}
+
+void run(const std::vector<std::uint64_t> & keys, const std::vector<double> & values)
+{
+    {
+        const Clock::time_point start = Clock::now();
+        HashMap<std::uint64_t, Totals, LinearProbing, MixHash<std::uint64_t>> map;
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            Totals & totals = map[keys[i]];
+            ++totals.count;
+            totals.sum += values[i];
+            totals.min = std::min(totals.min, values[i]);
+            totals.max = std::max(totals.max, values[i]);
+        }
+        report("HashMap::operator[]", Clock::now() - start, keys.size(), map.size());
+    }
+    using Aggregator = HashAggregator<std::uint64_t, Count, Sum<double>, Min<double>, Max<double>>;
+    {
+        const Clock::time_point start = Clock::now();
+        Aggregator aggregator;
+        aggregator.consume(keys.data(), keys.size(), nullptr, values.data(), values.data(), values.data());
+        report("HashAggregator", Clock::now() - start, keys.size(), aggregator.size());
+    }
+    {
+        const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+        const Clock::time_point start = Clock::now();
+        Aggregator aggregator;
+        aggregator.consume_parallel(threads, keys.data(), keys.size(), nullptr, values.data(), values.data(), values.data());
+        report("HashAggregator, " + std::to_string(threads) + " thr", Clock::now() - start, keys.size(), aggregator.size());
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    const std::size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20'000'000;
+
+    std::mt19937_64 rng(rows);
+    std::vector<double> values(rows);
+    for (double & value : values) {
+        value = static_cast<double>(rng() % 1000);
+    }
+
+    std::cout << std::left << std::setw(26) << "aggregation" << std::right << std::setw(12) << "ns/row" << std::setw(12) << "groups" << '\n';
+    for (const std::size_t groups : {std::size_t{1000}, std::size_t{1'000'000}, rows / 2}) {
+        std::vector<std::uint64_t> keys(rows);
+        for (std::uint64_t & key : keys) {
+            key = rng() % groups;
+        }
+        run(keys, values);
+    }
+}
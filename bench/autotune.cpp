@@ -0,0 +1,70 @@
+#include "autotuner.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Recommends HashMap policies for a recorded trace or for a sample of integer keys.
+// usage: autotune <trace> [repetitions]
+//        autotune --keys <file with whitespace separated unsigned integers> [repetitions]
+
+namespace {
+
+void report(const TuningReport & report, const std::string & key)
+{
+    report.print(std::cout);
+    std::cout << "\nfastest:  " << report.fastest().type_name(key, "Value")
+              << "\nsmallest: " << report.smallest().type_name(key, "Value") << '\n';
+}
+
+// random keys absent from the sample, as many as there are keys
+std::vector<std::uint64_t> make_missing(const std::vector<std::uint64_t> & keys)
+{
+    const std::unordered_set<std::uint64_t> present(keys.begin(), keys.end());
+    std::vector<std::uint64_t> missing;
+    std::mt19937_64 rng(keys.size());
+    while (missing.size() < keys.size()) {
+        if (const std::uint64_t key = rng(); present.count(key) == 0) {
+            missing.push_back(key);
+        }
+    }
+    return missing;
+}
+
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    try {
+        if (argc >= 3 && std::strcmp(argv[1], "--keys") == 0) {
+            std::ifstream in(argv[2]);
+            if (!in) {
+                throw std::runtime_error(std::string("cannot open ") + argv[2]);
+            }
+            std::vector<std::uint64_t> keys;
+            for (std::uint64_t key; in >> key;) {
+                keys.push_back(key);
+            }
+            const unsigned repetitions = argc > 3 ? std::stoul(argv[3]) : 3;
+            report(autotune<std::uint64_t>(keys, make_missing(keys), repetitions), "std::uint64_t");
+        }
+        else if (argc >= 2) {
+            const unsigned repetitions = argc > 2 ? std::stoul(argv[2]) : 3;
+            report(autotune(read_trace(argv[1]), repetitions), "std::uint64_t");
+        }
+        else {
+            std::cerr << "usage: autotune <trace> [repetitions]\n"
+                         "       autotune --keys <file> [repetitions]\n";
+            return 1;
+        }
+    }
+    catch (const std::exception & e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+}
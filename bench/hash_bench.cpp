@@ -0,0 +1,218 @@
+#include "hash_map.h"
+#include "hash_set.h"
+#include "keys.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+
+// Matrix of HashMap and HashSet configurations (collision policy x range hashing) and key types
+// compared against std::unordered_map and std::unordered_set.
+// JSON output for tracking results over time:
+//   hash_bench --benchmark_out=results.json --benchmark_out_format=json
+
+namespace {
+
+using Value = std::uint64_t;
+
+template <class Key, class CollisionPolicy, class RangeHash = MaskRangeHashing>
+using OpenAddressingMap = HashMap<Key, Value, CollisionPolicy, BenchHash<Key>, std::equal_to<Key>, RangeHash>;
+
+template <class Key, class CollisionPolicy, class RangeHash = MaskRangeHashing>
+using OpenAddressingSet = HashSet<Key, CollisionPolicy, BenchHash<Key>, std::equal_to<Key>, RangeHash>;
+
+template <class Key>
+using StdMap = std::unordered_map<Key, Value, BenchHash<Key>>;
+
+template <class Key>
+using StdSet = std::unordered_set<Key, BenchHash<Key>>;
+
+template <class Table>
+constexpr bool is_set = std::is_same_v<typename Table::key_type, typename Table::value_type>;
+
+template <class Table, class Key>
+void add_key(Table & table, const Key & key)
+{
+    if constexpr (is_set<Table>) {
+        table.insert(key);
+    }
+    else {
+        table.try_emplace(key, 1);
+    }
+}
+
+// what iteration accumulates
+template <class Table, class Entry>
+Value weight(const Entry & entry)
+{
+    if constexpr (is_set<Table>) {
+        return 1;
+    }
+    else {
+        return entry.second;
+    }
+}
+
+// from L1 resident tables to DRAM sized ones
+constexpr std::int64_t min_size = 1 << 8;
+constexpr std::int64_t max_size = 1 << 22;
+
+template <class Map, class Key>
+Map build(const std::vector<Key> & keys)
+{
+    Map map;
+    for (const Key & key : keys) {
+        add_key(map, key);
+    }
+    return map;
+}
+
+template <class Map>
+void bm_insert(benchmark::State & state)
+{
+    using Key = typename Map::key_type;
+    const auto keys = make_keys<Key>(state.range(0)).first;
+    for (auto _ : state) {
+        Map map;
+        for (const Key & key : keys) {
+            add_key(map, key);
+        }
+        benchmark::DoNotOptimize(map);
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template <class Map>
+void bm_find_hit(benchmark::State & state)
+{
+    using Key = typename Map::key_type;
+    auto keys = make_keys<Key>(state.range(0)).first;
+    const Map map = build<Map>(keys);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64{2});
+    for (auto _ : state) {
+        for (const Key & key : keys) {
+            benchmark::DoNotOptimize(map.find(key));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template <class Map>
+void bm_find_miss(benchmark::State & state)
+{
+    using Key = typename Map::key_type;
+    const auto [keys, missing] = make_keys<Key>(state.range(0));
+    const Map map = build<Map>(keys);
+    for (auto _ : state) {
+        for (const Key & key : missing) {
+            benchmark::DoNotOptimize(map.find(key));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * missing.size());
+}
+
+template <class Map>
+void bm_erase(benchmark::State & state)
+{
+    using Key = typename Map::key_type;
+    const auto keys = make_keys<Key>(state.range(0)).first;
+    const Map full = build<Map>(keys);
+    for (auto _ : state) {
+        state.PauseTiming();
+        Map map = full;
+        state.ResumeTiming();
+        for (const Key & key : keys) {
+            map.erase(key);
+        }
+        benchmark::DoNotOptimize(map);
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template <class Map>
+void bm_iterate(benchmark::State & state)
+{
+    using Key = typename Map::key_type;
+    const Map map = build<Map>(make_keys<Key>(state.range(0)).first);
+    for (auto _ : state) {
+        Value sum = 0;
+        for (const auto & value : map) {
+            sum += weight<Map>(value);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * map.size());
+}
+
+template <class Map>
+void bm_rehash(benchmark::State & state)
+{
+    using Key = typename Map::key_type;
+    const Map full = build<Map>(make_keys<Key>(state.range(0)).first);
+    for (auto _ : state) {
+        state.PauseTiming();
+        Map map = full;
+        state.ResumeTiming();
+        map.rehash(map.bucket_count() * 2);
+        benchmark::DoNotOptimize(map);
+    }
+    state.SetItemsProcessed(state.iterations() * full.size());
+}
+
+template <class Map>
+void register_map(const std::string & name)
+{
+    const auto add = [&name](const std::string & operation, void (*fn)(benchmark::State &)) {
+        benchmark::RegisterBenchmark((name + "/" + operation).c_str(), fn)
+                ->RangeMultiplier(16)
+                ->Range(min_size, max_size);
+    };
+    add("insert", bm_insert<Map>);
+    add("find_hit", bm_find_hit<Map>);
+    add("find_miss", bm_find_miss<Map>);
+    add("erase", bm_erase<Map>);
+    add("iterate", bm_iterate<Map>);
+    add("rehash", bm_rehash<Map>);
+}
+
+template <class Key, class RangeHash>
+void register_range_hash(const std::string & range_name, const std::string & key_name)
+{
+    register_map<OpenAddressingMap<Key, LinearProbing, RangeHash>>("linear_" + range_name + "/" + key_name);
+    register_map<OpenAddressingMap<Key, QuadraticProbing, RangeHash>>("quadratic_" + range_name + "/" + key_name);
+    register_map<OpenAddressingSet<Key, LinearProbing, RangeHash>>("set_linear_" + range_name + "/" + key_name);
+    register_map<OpenAddressingSet<Key, QuadraticProbing, RangeHash>>("set_quadratic_" + range_name + "/" + key_name);
+}
+
+template <class Key>
+void register_key(const std::string & key_name)
+{
+    register_range_hash<Key, MaskRangeHashing>("mask", key_name);
+    register_range_hash<Key, FibonacciRangeHashing>("fibonacci", key_name);
+    register_range_hash<Key, FastRangeHashing>("fastrange", key_name);
+    register_map<StdMap<Key>>("std_unordered_map/" + key_name);
+    register_map<StdSet<Key>>("std_unordered_set/" + key_name);
+}
+
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    register_key<int>("int");
+    register_key<std::uint64_t>("uint64");
+    register_key<std::string>("string");
+    register_key<Key32>("key32");
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+}
@@ -0,0 +1,43 @@
+#include "hash_functions.h"
+#include "hash_quality.h"
+#include "keys.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Runs the hash quality analysis over the hash functions used in the benchmarks.
+// A CI check for a custom hash is the same call with its own key sample:
+//     return analyze_hash<MyKey, MyHash>(sample).acceptable() ? 0 : 1;
+// usage: hash_quality [sample size = 100000]
+
+namespace {
+
+template <class Key, class Hash = std::hash<Key>>
+void analyze(const std::string & title, const std::vector<Key> & keys)
+{
+    std::cout << "=== " << title << " ===\n";
+    analyze_hash<Key, Hash>(keys).print(std::cout);
+    std::cout << '\n';
+}
+
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    const std::size_t size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000;
+
+    const auto random_keys = make_keys<std::uint64_t>(size).first;
+    std::vector<std::uint64_t> page_keys;
+    for (std::uint64_t i = 0; i < size; ++i) {
+        page_keys.push_back(i * 4096);
+    }
+
+    analyze("std::hash<uint64_t>, random keys", random_keys);
+    analyze("std::hash<uint64_t>, page aligned keys", page_keys);
+    analyze<std::uint64_t, MixHash<std::uint64_t>>("MixHash<uint64_t>, page aligned keys", page_keys);
+    analyze<Key32, Key32Hash>("Key32Hash", make_keys<Key32>(size).first);
+    analyze("std::hash<string>", make_keys<std::string>(size).first);
+}
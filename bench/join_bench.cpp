@@ -0,0 +1,69 @@
+#include "hash_join.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Inner, semi and anti join of a probe column against a build column larger than the cache,
+// probing row by row (a batch of one) and in prefetched batches of several sizes.
+// Build keys repeat twice on average, half of the probe keys have matches.
+// usage: join_bench [build rows = 10000000] [probe rows = 20000000]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <std::size_t BatchSize>
+void run(const std::vector<std::uint64_t> & build, const std::vector<std::uint64_t> & probe)
+{
+    HashJoin<std::uint64_t, std::hash<std::uint64_t>, std::equal_to<std::uint64_t>, BatchSize> join;
+    const Clock::time_point start = Clock::now();
+    join.build(build.data(), build.size());
+    const Clock::duration build_time = Clock::now() - start;
+
+    std::cout << std::setw(8) << BatchSize << std::fixed << std::setprecision(2)
+              << std::setw(12) << 1e9 * std::chrono::duration<double>(build_time).count() / build.size();
+    JoinOutput out;
+    out.probe_rows.reserve(2 * probe.size());
+    out.build_rows.reserve(2 * probe.size());
+    for (const JoinType type : {JoinType::Inner, JoinType::Semi, JoinType::Anti}) {
+        out.clear();
+        const Clock::time_point probe_start = Clock::now();
+        join.probe(probe.data(), probe.size(), type, out);
+        const double ns = 1e9 * std::chrono::duration<double>(Clock::now() - probe_start).count() / probe.size();
+        std::cout << std::setw(12) << ns << std::setw(12) << out.size();
+    }
+    std::cout << '\n';
+}
+
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    const std::size_t build_rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+    const std::size_t probe_rows = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20'000'000;
+
+    std::mt19937_64 rng(build_rows);
+    std::vector<std::uint64_t> build(build_rows);
+    for (std::uint64_t & key : build) {
+        key = rng() % (build_rows / 2 + 1);
+    }
+    std::vector<std::uint64_t> probe(probe_rows);
+    for (std::uint64_t & key : probe) {
+        key = rng() % (build_rows + 1);
+    }
+
+    std::cout << std::setw(8) << "batch" << std::setw(12) << "build ns"
+              << std::setw(12) << "inner ns" << std::setw(12) << "pairs"
+              << std::setw(12) << "semi ns" << std::setw(12) << "rows"
+              << std::setw(12) << "anti ns" << std::setw(12) << "rows" << '\n';
+    run<1>(build, probe);
+    run<8>(build, probe);
+    run<32>(build, probe);
+    run<128>(build, probe);
+}
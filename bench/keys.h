@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 32-byte key to measure the cost of moving and comparing wide keys
+struct Key32
+{
+    std::array<std::uint64_t, 4> words;
+
+    friend bool operator==(const Key32 & lhs, const Key32 & rhs)
+    {
+        return lhs.words == rhs.words;
+    }
+};
+
+struct Key32Hash
+{
+    std::size_t operator()(const Key32 & key) const noexcept
+    {
+        std::uint64_t h = 0;
+        for (const std::uint64_t word : key.words) {
+            h = (h ^ word) * 0x9e3779b97f4a7c15ULL;
+        }
+        return h;
+    }
+};
+
+template <class Key>
+struct BenchHash : std::hash<Key>
+{
+};
+
+template <>
+struct BenchHash<Key32> : Key32Hash
+{
+};
+
+template <class Key>
+Key make_key(const std::uint64_t x)
+{
+    if constexpr (std::is_same_v<Key, std::string>) {
+        // long enough to not fit into the small string buffer
+        std::string key = std::to_string(x);
+        key.insert(0, 24 - key.size(), 'k');
+        return key;
+    }
+    else if constexpr (std::is_same_v<Key, Key32>) {
+        return {{x, ~x, x * 3, x ^ 0x5555555555555555ULL}};
+    }
+    else {
+        return static_cast<Key>(x);
+    }
+}
+
+// `count` distinct keys to insert and `count` other keys to look up unsuccessfully
+template <class Key>
+std::pair<std::vector<Key>, std::vector<Key>> make_keys(const std::size_t count, const std::uint64_t seed = 1)
+{
+    std::vector<std::uint64_t> values(2 * count);
+    std::mt19937_64 rng(seed);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        // multiplication by an odd number is a bijection modulo 2^31, so values are distinct and fit into int
+        values[i] = (i * 0x9e3779b1ULL) & 0x7fffffffULL;
+    }
+    std::shuffle(values.begin(), values.end(), rng);
+    std::pair<std::vector<Key>, std::vector<Key>> result;
+    for (std::size_t i = 0; i < count; ++i) {
+        result.first.push_back(make_key<Key>(values[i]));
+        result.second.push_back(make_key<Key>(values[count + i]));
+    }
+    return result;
+}
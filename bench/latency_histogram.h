@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// HDR-style log-linear histogram of latencies in nanoseconds: values are grouped by their highest bit,
+// every group is split into linear sub-buckets, so relative error stays below 2^(1 - SubBucketBits)
+// for any value while the memory footprint stays constant.
+template <unsigned SubBucketBits = 7>
+class LatencyHistogram
+{
+public:
+    LatencyHistogram()
+        : m_counts(m_sub_buckets + (64 - SubBucketBits) * (m_sub_buckets / 2))
+    {
+    }
+
+    void record(const std::uint64_t value) noexcept
+    {
+        ++m_counts[bucket(value)];
+        ++m_total;
+        m_max = std::max(m_max, value);
+    }
+
+    void merge(const LatencyHistogram & other)
+    {
+        for (std::size_t i = 0; i < m_counts.size(); ++i) {
+            m_counts[i] += other.m_counts[i];
+        }
+        m_total += other.m_total;
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    std::uint64_t count() const noexcept
+    {
+        return m_total;
+    }
+
+    std::uint64_t max() const noexcept
+    {
+        return m_max;
+    }
+
+    // upper bound of the bucket holding the given quantile, `q` is in [0, 1]
+    std::uint64_t percentile(const double q) const noexcept
+    {
+        if (m_total == 0) {
+            return 0;
+        }
+        const auto rank = static_cast<std::uint64_t>(q * (m_total - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < m_counts.size(); ++i) {
+            seen += m_counts[i];
+            if (seen >= rank) {
+                return std::min(upper_bound(i), m_max);
+            }
+        }
+        return m_max;
+    }
+
+private:
+    static constexpr std::uint64_t m_sub_buckets = std::uint64_t{1} << SubBucketBits;
+
+    std::vector<std::uint64_t> m_counts;
+    std::uint64_t m_total = 0;
+    std::uint64_t m_max = 0;
+
+    // values below 2^SubBucketBits are stored exactly, larger ones are grouped by their highest bit,
+    // each group taking 2^(SubBucketBits - 1) buckets
+    static std::size_t bucket(const std::uint64_t value) noexcept
+    {
+        if (value < m_sub_buckets) {
+            return value;
+        }
+        const unsigned magnitude = 63 - __builtin_clzll(value) - SubBucketBits + 1;
+        return m_sub_buckets + (magnitude - 1) * (m_sub_buckets / 2) + ((value >> magnitude) - m_sub_buckets / 2);
+    }
+
+    static std::uint64_t upper_bound(const std::size_t index) noexcept
+    {
+        if (index < m_sub_buckets) {
+            return index;
+        }
+        const std::size_t group = (index - m_sub_buckets) / (m_sub_buckets / 2);
+        const std::uint64_t sub = (index - m_sub_buckets) % (m_sub_buckets / 2) + m_sub_buckets / 2;
+        return ((sub + 1) << (group + 1)) - 1;
+    }
+};
@@ -0,0 +1,220 @@
+#include "hash_map.h"
+#include "hash_set.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <unistd.h>
+
+// Bytes per live entry of HashMap/HashSet and their std counterparts, as seen by the allocator
+// (replaced global operator new/delete) and by the kernel (resident set size).
+// Every size is measured three times:
+//   grown    - inserting `size` entries one by one into an empty table
+//   worst    - continuing until the next growth, i.e. right after a rehash
+//   reserved - reserve(size) followed by `size` insertions
+// usage: memory_bench [size...]
+
+namespace {
+
+struct AllocationCounter
+{
+    std::size_t live = 0;
+    std::size_t peak = 0;
+};
+
+AllocationCounter allocations;
+
+// operator delete without size is called as well, so the size is kept in front of every block;
+// the replacements are not inlined to keep the compiler from pairing std::free with operator new
+constexpr std::size_t header_size = alignof(std::max_align_t);
+
+} // anonymous namespace
+
+__attribute__((noinline)) void * operator new(const std::size_t size)
+{
+    auto * block = static_cast<std::byte *>(std::malloc(size + header_size));
+    if (block == nullptr) {
+        throw std::bad_alloc{};
+    }
+    *reinterpret_cast<std::size_t *>(block) = size;
+    allocations.live += size;
+    allocations.peak = std::max(allocations.peak, allocations.live);
+    return block + header_size;
+}
+
+__attribute__((noinline)) void operator delete(void * ptr) noexcept
+{
+    if (ptr == nullptr) {
+        return;
+    }
+    auto * block = static_cast<std::byte *>(ptr) - header_size;
+    allocations.live -= *reinterpret_cast<std::size_t *>(block);
+    std::free(block);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+namespace {
+
+std::size_t resident_bytes()
+{
+    std::size_t pages = 0;
+    std::size_t resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    statm >> pages >> resident;
+    return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+struct Footprint
+{
+    std::size_t entries = 0;
+    std::size_t bucket_count = 0;
+    std::size_t live = 0;
+    std::size_t peak = 0;
+    std::size_t resident = 0;
+};
+
+class Probe
+{
+public:
+    Probe()
+        : m_live(allocations.live)
+        , m_resident(resident_bytes())
+    {
+        allocations.peak = allocations.live;
+    }
+
+    template <class Container>
+    Footprint take(const Container & container) const
+    {
+        const std::size_t resident = resident_bytes();
+        return {container.size(),
+                container.bucket_count(),
+                allocations.live - m_live,
+                allocations.peak - m_live,
+                resident > m_resident ? resident - m_resident : 0};
+    }
+
+private:
+    const std::size_t m_live;
+    const std::size_t m_resident;
+};
+
+void print_header()
+{
+    std::cout << std::left << std::setw(36) << "container"
+              << std::setw(10) << "state"
+              << std::right << std::setw(10) << "size"
+              << std::setw(10) << "buckets"
+              << std::setw(12) << "live B/e"
+              << std::setw(12) << "peak B/e"
+              << std::setw(12) << "rss B/e" << '\n';
+}
+
+void print_row(const std::string & container, const std::string & state, const Footprint & footprint)
+{
+    const auto per_entry = [&footprint](const std::size_t bytes) {
+        return footprint.entries != 0 ? 1.0 * bytes / footprint.entries : 0;
+    };
+    std::cout << std::left << std::setw(36) << container
+              << std::setw(10) << state
+              << std::right << std::setw(10) << footprint.entries
+              << std::setw(10) << footprint.bucket_count
+              << std::fixed << std::setprecision(1)
+              << std::setw(12) << per_entry(footprint.live)
+              << std::setw(12) << per_entry(footprint.peak)
+              << std::setw(12) << per_entry(footprint.resident) << '\n';
+}
+
+template <class Container, class MakeEntry>
+void measure(const std::string & name, const std::size_t size, MakeEntry make_entry)
+{
+    {
+        const Probe probe;
+        Container container;
+        std::size_t i = 0;
+        for (; i < size; ++i) {
+            container.insert(make_entry(i));
+        }
+        print_row(name, "grown", probe.take(container));
+
+        const std::size_t bucket_count = container.bucket_count();
+        while (container.bucket_count() == bucket_count) {
+            container.insert(make_entry(i++));
+        }
+        print_row(name, "worst", probe.take(container));
+    }
+    {
+        const Probe probe;
+        Container container;
+        container.reserve(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            container.insert(make_entry(i));
+        }
+        print_row(name, "reserved", probe.take(container));
+    }
+}
+
+std::uint64_t key(const std::size_t i)
+{
+    return i * 0x9e3779b97f4a7c15ULL;
+}
+
+std::string string_key(const std::size_t i)
+{
+    // does not fit into the small string buffer
+    std::string result = std::to_string(i);
+    result.insert(0, 24 - result.size(), 'k');
+    return result;
+}
+
+using Wide = std::array<std::uint64_t, 4>;
+
+// grows by 1.5x past 2^16 buckets, so that the effect shows at the default sizes
+using GradualMap = HashMap<std::uint64_t, std::uint64_t, LinearProbing, std::hash<std::uint64_t>, std::equal_to<std::uint64_t>,
+                           FastRangeHashing, GradualGrowthRehashPolicy<std::size_t{1} << 16>>;
+
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; ++i) {
+        sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+    }
+    if (sizes.empty()) {
+        sizes = {1 << 10, 1 << 16, 1 << 20, 1 << 23};
+    }
+
+    const auto set_entry = [](const std::size_t i) { return key(i); };
+    const auto map_entry = [](const std::size_t i) { return std::pair<const std::uint64_t, std::uint64_t>{key(i), i}; };
+    const auto wide_entry = [](const std::size_t i) { return std::pair<const std::uint64_t, Wide>{key(i), Wide{i}}; };
+    const auto string_entry = [](const std::size_t i) { return std::pair<const std::string, std::uint64_t>{string_key(i), i}; };
+
+    print_header();
+    for (const std::size_t size : sizes) {
+        measure<HashSet<std::uint64_t>>("HashSet<u64>", size, set_entry);
+        measure<std::unordered_set<std::uint64_t>>("std::unordered_set<u64>", size, set_entry);
+        measure<HashMap<std::uint64_t, std::uint64_t>>("HashMap<u64, u64>", size, map_entry);
+        measure<std::unordered_map<std::uint64_t, std::uint64_t>>("std::unordered_map<u64, u64>", size, map_entry);
+        measure<GradualMap>("HashMap<u64, u64> 1.5x growth", size, map_entry);
+        measure<HashMap<std::uint64_t, Wide>>("HashMap<u64, 32B>", size, wide_entry);
+        measure<std::unordered_map<std::uint64_t, Wide>>("std::unordered_map<u64, 32B>", size, wide_entry);
+        measure<HashMap<std::string, std::uint64_t>>("HashMap<string, u64>", size, string_entry);
+        measure<std::unordered_map<std::string, std::uint64_t>>("std::unordered_map<string, u64>", size, string_entry);
+        std::cout << '\n';
+    }
+}
@@ -0,0 +1,87 @@
+#include "hash_functions.h"
+#include "hash_map.h"
+#include "partitioned_hash_map.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Bulk build and probe of a table larger than the cache: HashMap row by row against
+// PartitionedHashMap on one and on all hardware threads.
+// Half of the probe keys are present, matches are counted in the order the tables produce them.
+// usage: partitioned_bench [rows = 20000000]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ns_per_row(const Clock::duration duration, const std::size_t rows)
+{
+    return 1e9 * std::chrono::duration<double>(duration).count() / rows;
+}
+
+void report(const std::string & name, const Clock::duration build, const Clock::duration probe, const std::size_t rows, const std::size_t matches)
+{
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(14) << ns_per_row(build, rows)
+              << std::setw(14) << ns_per_row(probe, rows)
+              << std::setw(12) << matches << '\n';
+}
+
+void row_by_row(const std::vector<std::uint64_t> & keys, const std::vector<std::uint32_t> & values, const std::vector<std::uint64_t> & probes)
+{
+    const Clock::time_point start = Clock::now();
+    HashMap<std::uint64_t, std::uint32_t, LinearProbing, MixHash<std::uint64_t>> map(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        map.try_emplace(keys[i], values[i]);
+    }
+    const Clock::time_point built = Clock::now();
+    std::size_t matches = 0;
+    for (const std::uint64_t key : probes) {
+        matches += map.find(key) != map.end();
+    }
+    report("HashMap, row by row", built - start, Clock::now() - built, keys.size(), matches);
+}
+
+void partitioned(const std::vector<std::uint64_t> & keys, const std::vector<std::uint32_t> & values, const std::vector<std::uint64_t> & probes, const unsigned threads)
+{
+    PartitionedHashMap<std::uint64_t, std::uint32_t> map;
+    const Clock::time_point start = Clock::now();
+    map.build(keys.data(), values.data(), keys.size(), threads);
+    const Clock::time_point built = Clock::now();
+    std::atomic<std::size_t> matches{0};
+    map.probe(probes.data(), probes.size(), [&matches](std::size_t, const std::uint32_t &) { matches.fetch_add(1, std::memory_order_relaxed); }, threads);
+    const Clock::time_point probed = Clock::now();
+    report("Partitioned, " + std::to_string(map.partition_count()) + " parts, " + std::to_string(threads) + " thr",
+           built - start, probed - built, keys.size(), matches);
+}
+
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    const std::size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20'000'000;
+
+    std::mt19937_64 rng(rows);
+    std::vector<std::uint64_t> keys(rows);
+    std::vector<std::uint32_t> values(rows);
+    std::vector<std::uint64_t> probes(rows);
+    for (std::size_t i = 0; i < rows; ++i) {
+        keys[i] = rng();
+        values[i] = static_cast<std::uint32_t>(i);
+        probes[i] = i % 2 == 0 ? keys[rng() % rows] : rng();
+    }
+
+    std::cout << std::left << std::setw(28) << "table" << std::right
+              << std::setw(14) << "build ns/row" << std::setw(14) << "probe ns/row" << std::setw(12) << "matches" << '\n';
+    row_by_row(keys, values, probes);
+    partitioned(keys, values, probes, 1);
+    partitioned(keys, values, probes, std::max(1u, std::thread::hardware_concurrency()));
+}
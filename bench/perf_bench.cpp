@@ -0,0 +1,109 @@
+#include "hash_map.h"
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+void print_header()
+{
+    std::cout << std::left << std::setw(12) << "table"
+              << std::setw(12) << "operation"
+              << std::right << std::setw(10) << "size"
+              << std::setw(10) << "ns/op";
+    for (const char * name : PerfCounters::names) {
+        std::cout << std::setw(18) << std::string(name) + "/op";
+    }
+    std::cout << '\n';
+}
+
+void print_row(const std::string & table,
+               const std::string & operation,
+               const std::size_t size,
+               const PerfCounters::Result & result)
+{
+    std::cout << std::left << std::setw(12) << table
+              << std::setw(12) << operation
+              << std::right << std::setw(10) << size
+              << std::setw(10) << std::fixed << std::setprecision(2) << result.ns_per(size);
+    for (std::size_t i = 0; i < PerfCounters::EventCount; ++i) {
+        if (const auto value = result.per(static_cast<PerfCounters::Event>(i), size)) {
+            std::cout << std::setw(18) << *value;
+        }
+        else {
+            std::cout << std::setw(18) << "-";
+        }
+    }
+    std::cout << '\n';
+}
+
+template <class Map>
+std::uint64_t run(PerfCounters & counters, const std::string & table, const std::vector<std::uint64_t> & keys, const std::vector<std::uint64_t> & missing)
+{
+    std::uint64_t checksum = 0;
+    Map map;
+    print_row(table, "insert", keys.size(), counters.measure([&] {
+        for (const std::uint64_t key : keys) {
+            map.try_emplace(key, key);
+        }
+    }));
+    std::vector<std::uint64_t> shuffled = keys;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937_64{1});
+    print_row(table, "find-hit", keys.size(), counters.measure([&] {
+        for (const std::uint64_t key : shuffled) {
+            checksum += map.find(key)->second;
+        }
+    }));
+    print_row(table, "find-miss", missing.size(), counters.measure([&] {
+        for (const std::uint64_t key : missing) {
+            checksum += map.count(key);
+        }
+    }));
+    return checksum;
+}
+
+} // anonymous namespace
+
+// usage: perf_bench [size...]
+int main(int argc, char ** argv)
+{
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; ++i) {
+        sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+        // per operation figures divide by the size
+        if (sizes.back() == 0) {
+            std::cerr << "usage: perf_bench [size...], sizes should be positive numbers\n";
+            return 1;
+        }
+    }
+    if (sizes.empty()) {
+        sizes = {1 << 10, 1 << 16, 1 << 20, 1 << 23};
+    }
+
+    PerfCounters counters;
+    if (!counters.available()) {
+        std::cout << "hardware counters are not available, reporting time only\n";
+    }
+    print_header();
+
+    std::uint64_t checksum = 0;
+    for (const std::size_t size : sizes) {
+        std::mt19937_64 rng(size);
+        std::vector<std::uint64_t> keys(size);
+        std::vector<std::uint64_t> missing(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            keys[i] = rng() | 1;
+            missing[i] = rng() & ~std::uint64_t{1};
+        }
+        checksum += run<HashMap<std::uint64_t, std::uint64_t, LinearProbing>>(counters, "linear", keys, missing);
+        checksum += run<HashMap<std::uint64_t, std::uint64_t, QuadraticProbing>>(counters, "quadratic", keys, missing);
+    }
+    std::cerr << "checksum " << checksum << '\n';
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware counters around a measured region, opened through perf_event_open.
+// Every counter is opened on its own, so unavailable ones (no PMU access in containers,
+// perf_event_paranoid, non-Linux systems) are simply missing from the result
+// and the measurement degrades to wall clock time.
+class PerfCounters
+{
+public:
+    enum Event
+    {
+        Instructions,
+        CacheMisses,
+        BranchMisses,
+        TlbMisses,
+        EventCount
+    };
+
+    static constexpr std::array<const char *, EventCount> names = {"instructions", "cache-misses", "branch-misses", "dtlb-misses"};
+
+    struct Result
+    {
+        std::chrono::nanoseconds elapsed{0};
+        std::array<std::optional<double>, EventCount> counts;
+
+        // per operation figures
+        double ns_per(const std::uint64_t ops) const
+        {
+            return 1.0 * elapsed.count() / ops;
+        }
+
+        std::optional<double> per(const Event event, const std::uint64_t ops) const
+        {
+            if (!counts[event]) {
+                return std::nullopt;
+            }
+            return *counts[event] / ops;
+        }
+    };
+
+    PerfCounters()
+    {
+        m_fds.fill(-1);
+#ifdef __linux__
+        open(Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        open(CacheMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        open(BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        open(TlbMisses,
+             PERF_TYPE_HW_CACHE,
+             PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#endif
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters & operator=(const PerfCounters &) = delete;
+
+    ~PerfCounters()
+    {
+#ifdef __linux__
+        for (const int fd : m_fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    // whether at least one hardware counter could be opened
+    bool available() const
+    {
+        for (const int fd : m_fds) {
+            if (fd >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        for (const int fd : m_fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    Result stop()
+    {
+        Result result;
+        result.elapsed = std::chrono::steady_clock::now() - m_start;
+#ifdef __linux__
+        for (std::size_t i = 0; i < EventCount; ++i) {
+            if (m_fds[i] < 0) {
+                continue;
+            }
+            ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            // value, time enabled, time running: scale the value if the counter was multiplexed
+            std::array<std::uint64_t, 3> values{};
+            if (read(m_fds[i], values.data(), sizeof(values)) == sizeof(values) && values[2] != 0) {
+                result.counts[i] = 1.0 * values[0] * values[1] / values[2];
+            }
+        }
+#endif
+        return result;
+    }
+
+    template <class F>
+    Result measure(F && f)
+    {
+        start();
+        f();
+        return stop();
+    }
+
+private:
+    std::array<int, EventCount> m_fds;
+    std::chrono::steady_clock::time_point m_start;
+
+#ifdef __linux__
+    void open(const Event event, const std::uint32_t type, const std::uint64_t config)
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        m_fds[event] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+};
@@ -0,0 +1,95 @@
+#include "hash_map.h"
+#include "latency_histogram.h"
+#include "segmented_hash_map.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Grows a table from empty, timing every single insert, and reports the latency distribution
+// along with the rehashes which caused its tail. `segmented` grows a SegmentedHashMap instead,
+// which splits one segment at a time and has no table-wide rehashes.
+// usage: tail_latency [entries = 100000000] [hash_map|segmented]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct RehashRecord
+{
+    double at_ms;
+    std::size_t size;
+    std::size_t old_bucket_count;
+    std::size_t new_bucket_count;
+    double duration_ms;
+};
+
+double to_ms(const Clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+template <class Map>
+void fill(Map & map, const std::size_t entries, LatencyHistogram<> & histogram)
+{
+    std::mt19937_64 rng(entries);
+    for (std::size_t i = 0; i < entries; ++i) {
+        const std::uint64_t key = rng();
+        const Clock::time_point start = Clock::now();
+        map.try_emplace(key, i);
+        const Clock::time_point stop = Clock::now();
+        histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    const std::size_t entries = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000'000;
+    const bool segmented = argc > 2 && std::string(argv[2]) == "segmented";
+
+    LatencyHistogram<> histogram;
+    std::vector<RehashRecord> rehashes;
+
+    const Clock::time_point begin = Clock::now();
+    if (segmented) {
+        SegmentedHashMap<std::uint64_t, std::uint64_t> map;
+        fill(map, entries, histogram);
+        std::cout << "segments: " << map.segment_count() << ", directory depth " << map.global_depth() << '\n';
+    }
+    else {
+        HashMap<std::uint64_t, std::uint64_t> map;
+        map.set_rehash_hook([&](const RehashEvent & event) {
+            if (event.phase == RehashEvent::Phase::After) {
+                rehashes.push_back({to_ms(Clock::now() - begin - event.duration),
+                                    event.size,
+                                    event.old_bucket_count,
+                                    event.new_bucket_count,
+                                    to_ms(event.duration)});
+            }
+        });
+        fill(map, entries, histogram);
+    }
+    const double total_ms = to_ms(Clock::now() - begin);
+
+    std::cout << "inserts: " << histogram.count() << ", total " << std::fixed << std::setprecision(1) << total_ms << " ms\n"
+              << "p50:   " << histogram.percentile(0.5) << " ns\n"
+              << "p99:   " << histogram.percentile(0.99) << " ns\n"
+              << "p99.9: " << histogram.percentile(0.999) << " ns\n"
+              << "max:   " << histogram.max() << " ns\n"
+              << "\nrehashes:\n"
+              << std::setw(12) << "at, ms" << std::setw(14) << "size" << std::setw(14) << "old buckets" << std::setw(14) << "new buckets" << std::setw(14) << "took, ms" << '\n';
+    for (const RehashRecord & rehash : rehashes) {
+        std::cout << std::setw(12) << rehash.at_ms
+                  << std::setw(14) << rehash.size
+                  << std::setw(14) << rehash.old_bucket_count
+                  << std::setw(14) << rehash.new_bucket_count
+                  << std::setw(14) << std::setprecision(3) << rehash.duration_ms << std::setprecision(1) << '\n';
+    }
+}
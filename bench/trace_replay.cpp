@@ -0,0 +1,100 @@
+#include "hash_functions.h"
+#include "hash_map.h"
+#include "tracing_hash_map.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Re-executes a trace recorded by TracingHashMap against several policy configurations.
+// Keys are the recorded tokens, which are hash values already, so they are hashed with identity:
+// a trace recorded without anonymization reproduces the original bucket distribution.
+// Every configuration is replayed twice, without instrumentation for timing and with
+// CountingStats for probe statistics.
+// usage: trace_replay <trace> [repetitions = 5]
+
+namespace {
+
+template <class CollisionPolicy, class RangeHash, class StatsPolicy = NoStats>
+using Map = HashMap<std::uint64_t, std::uint64_t, CollisionPolicy, IdentityHash, std::equal_to<std::uint64_t>, RangeHash, Power2RehashPolicy, NoAccessTracking, NoFilter, StatsPolicy>;
+
+template <class CollisionPolicy, class RangeHash>
+void run(const std::string & name, const std::vector<TraceRecord> & trace, const unsigned repetitions)
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::duration best = Clock::duration::max();
+    std::uint64_t found = 0;
+    for (unsigned i = 0; i < repetitions; ++i) {
+        Map<CollisionPolicy, RangeHash> map;
+        const Clock::time_point start = Clock::now();
+        found = replay_trace(map, trace);
+        best = std::min(best, Clock::now() - start);
+    }
+
+    Map<CollisionPolicy, RangeHash, CountingStats> counted;
+    replay_trace(counted, trace);
+    const CountingStats::Counters & counters = counted.instrumentation().counters();
+    const TableStats stats = counted.stats();
+
+    std::cout << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << 1e9 * std::chrono::duration<double>(best).count() / trace.size()
+              << std::setw(12) << counters.probes_per_lookup()
+              << std::setw(12) << 1.0 * counters.tombstones_skipped / std::max<std::size_t>(counters.lookups, 1)
+              << std::setw(10) << counters.rehashes
+              << std::setw(14) << std::chrono::duration<double, std::milli>(counters.rehash_time).count()
+              << std::setw(12) << stats.average_probe_length
+              << std::setw(12) << stats.expected_miss_length
+              << std::setw(10) << found << '\n';
+}
+
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    if (argc < 2) {
+        std::cerr << "usage: trace_replay <trace> [repetitions]\n";
+        return 1;
+    }
+    const unsigned repetitions = argc > 2 ? std::max(1, std::stoi(argv[2])) : 5;
+
+    bool anonymized = false;
+    std::vector<TraceRecord> trace;
+    try {
+        trace = read_trace(argv[1], &anonymized);
+    }
+    catch (const std::exception & e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    if (trace.empty()) {
+        std::cerr << "empty trace\n";
+        return 1;
+    }
+
+    std::size_t ops[5] = {};
+    for (const TraceRecord & record : trace) {
+        ++ops[static_cast<std::size_t>(record.op)];
+    }
+    std::cout << trace.size() << " operations over " << trace.back().time_ns / 1e6 << " ms"
+              << (anonymized ? ", anonymized keys" : ", original hash values")
+              << ": " << ops[0] << " find, " << ops[1] << " insert, " << ops[2] << " erase, "
+              << ops[3] << " clear, " << ops[4] << " reserve\n\n";
+
+    std::cout << std::left << std::setw(22) << "configuration" << std::right
+              << std::setw(10) << "ns/op"
+              << std::setw(12) << "probes/op"
+              << std::setw(12) << "tombst/op"
+              << std::setw(10) << "rehashes"
+              << std::setw(14) << "rehash, ms"
+              << std::setw(12) << "final hit"
+              << std::setw(12) << "final miss"
+              << std::setw(10) << "found" << '\n';
+    run<LinearProbing, MaskRangeHashing>("linear_mask", trace, repetitions);
+    run<QuadraticProbing, MaskRangeHashing>("quadratic_mask", trace, repetitions);
+    run<LinearProbing, FibonacciRangeHashing>("linear_fibonacci", trace, repetitions);
+    run<QuadraticProbing, FibonacciRangeHashing>("quadratic_fibonacci", trace, repetitions);
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// YCSB-style operation mixes and key choosers.
+// Records are numbered densely from 0, `record_key` turns a record number into the table key
+// so that neighbouring records do not land into neighbouring buckets.
+
+enum class Operation
+{
+    Read,
+    Update,
+    Insert,
+    Scan,
+    ReadModifyWrite,
+    Count
+};
+
+inline const char * operation_name(const Operation operation)
+{
+    static constexpr const char * names[] = {"read", "update", "insert", "scan", "rmw"};
+    return names[static_cast<std::size_t>(operation)];
+}
+
+enum class Distribution
+{
+    Uniform,
+    Zipfian,
+    Latest
+};
+
+struct Workload
+{
+    // proportions of operations, sum up to 1
+    std::array<double, static_cast<std::size_t>(Operation::Count)> mix{};
+    Distribution distribution = Distribution::Zipfian;
+    std::size_t max_scan_length = 100;
+
+    // YCSB core workloads A-F plus an insert-heavy one
+    static Workload preset(const char name)
+    {
+        Workload w;
+        const auto set = [&w](const Operation operation, const double proportion) {
+            w.mix[static_cast<std::size_t>(operation)] = proportion;
+        };
+        switch (name) {
+        case 'A': // update heavy
+            set(Operation::Read, 0.5);
+            set(Operation::Update, 0.5);
+            break;
+        case 'B': // read mostly
+            set(Operation::Read, 0.95);
+            set(Operation::Update, 0.05);
+            break;
+        case 'C': // read only
+            set(Operation::Read, 1);
+            break;
+        case 'D': // read latest
+            set(Operation::Read, 0.95);
+            set(Operation::Insert, 0.05);
+            w.distribution = Distribution::Latest;
+            break;
+        case 'E': // short scans
+            set(Operation::Scan, 0.95);
+            set(Operation::Insert, 0.05);
+            break;
+        case 'F': // read-modify-write
+            set(Operation::Read, 0.5);
+            set(Operation::ReadModifyWrite, 0.5);
+            break;
+        case 'I': // insert heavy
+            set(Operation::Read, 0.1);
+            set(Operation::Insert, 0.9);
+            break;
+        default:
+            throw std::invalid_argument(std::string("unknown workload ") + name);
+        }
+        return w;
+    }
+};
+
+inline std::uint64_t record_key(std::uint64_t record) noexcept
+{
+    // murmur3 finalizer, a bijection
+    record ^= record >> 33;
+    record *= 0xff51afd7ed558ccdULL;
+    record ^= record >> 33;
+    record *= 0xc4ceb9fe1a85ec53ULL;
+    record ^= record >> 33;
+    return record;
+}
+
+// Zipfian distribution over [0, n) as in "Quickly Generating Billion-Record Synthetic Databases"
+// (Gray et al.), which is what YCSB uses; n may only grow, zeta is then extended incrementally.
+class ZipfianGenerator
+{
+public:
+    explicit ZipfianGenerator(const std::uint64_t n, const double theta = 0.99)
+        : m_theta(theta)
+        , m_alpha(1 / (1 - theta))
+        , m_zeta2(zeta(0, 2, 0))
+    {
+        resize(n);
+    }
+
+    template <class Rng>
+    std::uint64_t operator()(Rng & rng)
+    {
+        const double u = std::uniform_real_distribution<double>{}(rng);
+        const double uz = u * m_zetan;
+        if (uz < 1) {
+            return 0;
+        }
+        if (uz < 1 + std::pow(0.5, m_theta)) {
+            return 1;
+        }
+        const auto result = static_cast<std::uint64_t>(m_n * std::pow(m_eta * u - m_eta + 1, m_alpha));
+        return std::min(result, m_n - 1);
+    }
+
+    void resize(const std::uint64_t n)
+    {
+        if (n <= m_n) {
+            return;
+        }
+        m_zetan = zeta(m_n, n, m_zetan);
+        m_n = n;
+        m_eta = (1 - std::pow(2.0 / m_n, 1 - m_theta)) / (1 - m_zeta2 / m_zetan);
+    }
+
+private:
+    const double m_theta;
+    const double m_alpha;
+    const double m_zeta2;
+    std::uint64_t m_n = 0;
+    double m_zetan = 0;
+    double m_eta = 0;
+
+    double zeta(const std::uint64_t from, const std::uint64_t to, double sum) const
+    {
+        for (std::uint64_t i = from; i < to; ++i) {
+            sum += 1 / std::pow(i + 1, m_theta);
+        }
+        return sum;
+    }
+};
+
+// Record numbers of Insert operations, as YCSB's acknowledged counter: `next()` hands out a new
+// number before the insert, `acknowledge()` reports it done afterwards, and `acknowledged()` only
+// advances past numbers whose inserts have all returned, so that readers never pick a missing record
+class InsertSequence
+{
+public:
+    explicit InsertSequence(const std::uint64_t records)
+        : m_next(records)
+        , m_acknowledged(records)
+    {
+    }
+
+    std::uint64_t next() noexcept
+    {
+        return m_next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void acknowledge(const std::uint64_t record)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_done.push(record);
+        std::uint64_t acknowledged = m_acknowledged.load(std::memory_order_relaxed);
+        while (!m_done.empty() && m_done.top() == acknowledged) {
+            m_done.pop();
+            ++acknowledged;
+        }
+        m_acknowledged.store(acknowledged, std::memory_order_release);
+    }
+
+    // number of records known to be in the table
+    const std::atomic<std::uint64_t> & acknowledged() const noexcept
+    {
+        return m_acknowledged;
+    }
+
+private:
+    std::atomic<std::uint64_t> m_next;
+    std::atomic<std::uint64_t> m_acknowledged;
+    std::mutex m_mutex;
+    // finished inserts past the acknowledged ones
+    std::priority_queue<std::uint64_t, std::vector<std::uint64_t>, std::greater<>> m_done;
+};
+
+// Picks records among the `record_count` inserted so far, which grows as Insert operations run
+class KeyChooser
+{
+public:
+    KeyChooser(const Distribution distribution, const std::atomic<std::uint64_t> & record_count)
+        : m_distribution(distribution)
+        , m_record_count(record_count)
+        , m_zipfian(record_count.load(std::memory_order_relaxed))
+    {
+    }
+
+    template <class Rng>
+    std::uint64_t operator()(Rng & rng)
+    {
+        // pairs with the release in InsertSequence::acknowledge
+        const std::uint64_t n = m_record_count.load(std::memory_order_acquire);
+        switch (m_distribution) {
+        case Distribution::Uniform:
+            return std::uniform_int_distribution<std::uint64_t>{0, n - 1}(rng);
+        case Distribution::Zipfian:
+            // popular records are scattered over the key space instead of being the oldest ones
+            return record_key(m_zipfian(rng)) % n;
+        case Distribution::Latest:
+            m_zipfian.resize(n);
+            return n - 1 - m_zipfian(rng);
+        }
+        return 0;
+    }
+
+private:
+    const Distribution m_distribution;
+    const std::atomic<std::uint64_t> & m_record_count;
+    ZipfianGenerator m_zipfian;
+};
+
+class OperationChooser
+{
+public:
+    explicit OperationChooser(const Workload & workload)
+    {
+        double sum = 0;
+        for (std::size_t i = 0; i < m_thresholds.size(); ++i) {
+            sum += workload.mix[i];
+            m_thresholds[i] = sum;
+        }
+    }
+
+    template <class Rng>
+    Operation operator()(Rng & rng) const
+    {
+        const double u = std::uniform_real_distribution<double>{0, m_thresholds.back()}(rng);
+        for (std::size_t i = 0; i < m_thresholds.size(); ++i) {
+            if (u < m_thresholds[i]) {
+                return static_cast<Operation>(i);
+            }
+        }
+        return Operation::Read;
+    }
+
+private:
+    std::array<double, static_cast<std::size_t>(Operation::Count)> m_thresholds{};
+};
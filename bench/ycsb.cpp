@@ -0,0 +1,288 @@
+#include "hash_map.h"
+#include "latency_histogram.h"
+#include "workload.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Loads `records` records into a table, then replays a YCSB-style operation mix against it
+// from several threads and reports throughput and per-operation latency percentiles.
+// The table is shared between threads behind a reader-writer lock, the same way a service would
+// wrap a non-concurrent table, so the lock is taken even when running single-threaded.
+// usage: ycsb [workload=A|B|C|D|E|F|I] [distribution=uniform|zipfian|latest] [records=N]
+//             [operations=N] [threads=N] [table=linear|quadratic|std]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Value = std::uint64_t;
+
+struct Options
+{
+    char workload = 'A';
+    const char * distribution = nullptr;
+    std::uint64_t records = 1'000'000;
+    std::uint64_t operations = 10'000'000;
+    unsigned threads = 1;
+    std::string table = "linear";
+};
+
+template <class Map>
+class LockedTable
+{
+public:
+    bool read(const std::uint64_t key, Value & value) const
+    {
+        std::shared_lock lock(m_mutex);
+        const auto it = m_map.find(key);
+        if (it == m_map.end()) {
+            return false;
+        }
+        value = it->second;
+        return true;
+    }
+
+    bool update(const std::uint64_t key, const Value value)
+    {
+        std::unique_lock lock(m_mutex);
+        const auto it = m_map.find(key);
+        if (it == m_map.end()) {
+            return false;
+        }
+        it->second = value;
+        return true;
+    }
+
+    void insert(const std::uint64_t key, const Value value)
+    {
+        std::unique_lock lock(m_mutex);
+        m_map.try_emplace(key, value);
+    }
+
+    // there is no key order, so a scan walks the table's iteration order from the given key
+    std::size_t scan(const std::uint64_t key, const std::size_t length, Value & sum) const
+    {
+        std::shared_lock lock(m_mutex);
+        std::size_t visited = 0;
+        for (auto it = m_map.find(key); it != m_map.end() && visited < length; ++it, ++visited) {
+            sum += it->second;
+        }
+        return visited;
+    }
+
+    bool read_modify_write(const std::uint64_t key)
+    {
+        std::unique_lock lock(m_mutex);
+        const auto it = m_map.find(key);
+        if (it == m_map.end()) {
+            return false;
+        }
+        ++it->second;
+        return true;
+    }
+
+    std::size_t size() const
+    {
+        std::shared_lock lock(m_mutex);
+        return m_map.size();
+    }
+
+private:
+    mutable std::shared_mutex m_mutex;
+    Map m_map;
+};
+
+constexpr std::size_t operation_count = static_cast<std::size_t>(Operation::Count);
+
+struct ThreadResult
+{
+    std::array<LatencyHistogram<>, operation_count> latencies;
+    std::uint64_t not_found = 0;
+    Value checksum = 0;
+};
+
+template <class Map>
+void run(const Options & options, const Workload & workload)
+{
+    LockedTable<Map> table;
+    InsertSequence inserts(options.records);
+
+    const Clock::time_point load_begin = Clock::now();
+    for (std::uint64_t record = 0; record < options.records; ++record) {
+        table.insert(record_key(record), record);
+    }
+    const double load_seconds = std::chrono::duration<double>(Clock::now() - load_begin).count();
+
+    std::vector<ThreadResult> results(options.threads);
+    const auto worker = [&](const unsigned thread) {
+        ThreadResult & result = results[thread];
+        std::mt19937_64 rng(thread + 1);
+        KeyChooser choose_key(workload.distribution, inserts.acknowledged());
+        const OperationChooser choose_operation(workload);
+        std::uniform_int_distribution<std::size_t> scan_length(1, workload.max_scan_length);
+        const std::uint64_t operations = options.operations / options.threads + (thread < options.operations % options.threads);
+
+        for (std::uint64_t i = 0; i < operations; ++i) {
+            const Operation operation = choose_operation(rng);
+            bool found = true;
+            Value value = 0;
+            std::uint64_t record = 0;
+            const Clock::time_point start = Clock::now();
+            switch (operation) {
+            case Operation::Read:
+                found = table.read(record_key(choose_key(rng)), value);
+                break;
+            case Operation::Update:
+                found = table.update(record_key(choose_key(rng)), i);
+                break;
+            case Operation::Insert:
+                record = inserts.next();
+                table.insert(record_key(record), record);
+                break;
+            case Operation::Scan:
+                found = table.scan(record_key(choose_key(rng)), scan_length(rng), value) != 0;
+                break;
+            case Operation::ReadModifyWrite:
+                found = table.read_modify_write(record_key(choose_key(rng)));
+                break;
+            case Operation::Count:
+                break;
+            }
+            const Clock::time_point stop = Clock::now();
+            if (operation == Operation::Insert) {
+                inserts.acknowledge(record);
+            }
+            result.latencies[static_cast<std::size_t>(operation)].record(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+            result.not_found += !found;
+            result.checksum += value;
+        }
+    };
+
+    const Clock::time_point begin = Clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned thread = 0; thread < options.threads; ++thread) {
+        threads.emplace_back(worker, thread);
+    }
+    for (std::thread & thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    ThreadResult total;
+    for (const ThreadResult & result : results) {
+        for (std::size_t i = 0; i < operation_count; ++i) {
+            total.latencies[i].merge(result.latencies[i]);
+        }
+        total.not_found += result.not_found;
+        total.checksum += result.checksum;
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "load:       " << options.records << " records in " << load_seconds << " s\n"
+              << "run:        " << options.operations << " operations in " << seconds << " s, "
+              << options.operations / seconds / 1e6 << " Mops/s, " << options.threads << " threads\n"
+              << "not found:  " << total.not_found << '\n'
+              << "final size: " << table.size() << "\n\n"
+              << std::left << std::setw(10) << "operation" << std::right
+              << std::setw(12) << "count" << std::setw(10) << "p50, ns" << std::setw(10) << "p99, ns"
+              << std::setw(12) << "p99.9, ns" << std::setw(12) << "max, ns" << '\n';
+    for (std::size_t i = 0; i < operation_count; ++i) {
+        const LatencyHistogram<> & histogram = total.latencies[i];
+        if (histogram.count() == 0) {
+            continue;
+        }
+        std::cout << std::left << std::setw(10) << operation_name(static_cast<Operation>(i)) << std::right
+                  << std::setw(12) << histogram.count()
+                  << std::setw(10) << histogram.percentile(0.5)
+                  << std::setw(10) << histogram.percentile(0.99)
+                  << std::setw(12) << histogram.percentile(0.999)
+                  << std::setw(12) << histogram.max() << '\n';
+    }
+    std::cerr << "checksum " << total.checksum << '\n';
+}
+
+Options parse(const int argc, char ** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const auto eq = arg.find('=');
+        const std::string name = arg.substr(0, eq);
+        const char * value = eq == std::string::npos ? "" : argv[i] + eq + 1;
+        if (name == "workload") {
+            options.workload = value[0];
+        }
+        else if (name == "distribution") {
+            options.distribution = value;
+        }
+        else if (name == "records") {
+            options.records = std::max<std::uint64_t>(1, std::strtoull(value, nullptr, 10));
+        }
+        else if (name == "operations") {
+            options.operations = std::strtoull(value, nullptr, 10);
+        }
+        else if (name == "threads") {
+            options.threads = std::max(1u, static_cast<unsigned>(std::strtoul(value, nullptr, 10)));
+        }
+        else if (name == "table") {
+            options.table = value;
+        }
+        else {
+            throw std::invalid_argument("unknown option " + arg);
+        }
+    }
+    return options;
+}
+
+} // anonymous namespace
+
+int main(int argc, char ** argv)
+{
+    try {
+        const Options options = parse(argc, argv);
+        Workload workload = Workload::preset(options.workload);
+        if (options.distribution != nullptr) {
+            if (std::strcmp(options.distribution, "uniform") == 0) {
+                workload.distribution = Distribution::Uniform;
+            }
+            else if (std::strcmp(options.distribution, "zipfian") == 0) {
+                workload.distribution = Distribution::Zipfian;
+            }
+            else if (std::strcmp(options.distribution, "latest") == 0) {
+                workload.distribution = Distribution::Latest;
+            }
+            else {
+                throw std::invalid_argument(std::string("unknown distribution ") + options.distribution);
+            }
+        }
+
+        if (options.table == "linear") {
+            run<HashMap<std::uint64_t, Value, LinearProbing>>(options, workload);
+        }
+        else if (options.table == "quadratic") {
+            run<HashMap<std::uint64_t, Value, QuadraticProbing>>(options, workload);
+        }
+        else if (options.table == "std") {
+            run<std::unordered_map<std::uint64_t, Value>>(options, workload);
+        }
+        else {
+            throw std::invalid_argument("unknown table " + options.table);
+        }
+    }
+    catch (const std::exception & e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+}
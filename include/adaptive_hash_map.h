@@ -0,0 +1,588 @@
+#pragma once
+
+#include "hash_map.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// `MigrationPolicy` of `AdaptiveHashMap`, decides when the container changes its representation
+struct DefaultMigrationPolicy
+{
+    // number of entries kept in the inline array before moving to a hash table
+    static constexpr std::size_t inline_capacity = 8;
+
+    // a hash table shrunk by erasures to `size` entries goes back to the inline array,
+    // only asked for sizes that fit into it
+    static constexpr bool to_inline(const std::size_t size) noexcept
+    {
+        return size <= inline_capacity / 2;
+    }
+
+    // a large hash table looked up many times since its last modification is frozen by `freeze_if_read_mostly()`
+    static constexpr bool to_frozen(const std::size_t size, const std::size_t lookups_since_modification) noexcept
+    {
+        return size >= (std::size_t{1} << 16) && lookups_since_modification >= 4 * size;
+    }
+};
+
+namespace adaptive_details {
+
+// Unordered entries stored inside the container itself, found by linear search
+template <class Key, class Value, std::size_t Capacity>
+class InlineArray
+{
+    static_assert(Capacity > 0, "inline array should hold at least one entry");
+
+public:
+    using Entry = std::pair<Key, Value>;
+
+    InlineArray() = default;
+
+    InlineArray(const InlineArray & other)
+    {
+        for (const Entry & entry : other) {
+            emplace(entry.first, entry.second);
+        }
+    }
+
+    InlineArray(InlineArray && other) noexcept(std::is_nothrow_move_constructible_v<Entry>)
+    {
+        for (Entry & entry : other) {
+            emplace(std::move(entry.first), std::move(entry.second));
+        }
+        other.clear();
+    }
+
+    InlineArray & operator=(InlineArray other) noexcept(std::is_nothrow_move_constructible_v<Entry>)
+    {
+        clear();
+        for (Entry & entry : other) {
+            emplace(std::move(entry.first), std::move(entry.second));
+        }
+        return *this;
+    }
+
+    ~InlineArray()
+    {
+        clear();
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    bool full() const noexcept
+    {
+        return m_size == Capacity;
+    }
+
+    Entry * begin() noexcept
+    {
+        return std::launder(reinterpret_cast<Entry *>(m_storage));
+    }
+
+    const Entry * begin() const noexcept
+    {
+        return std::launder(reinterpret_cast<const Entry *>(m_storage));
+    }
+
+    Entry * end() noexcept
+    {
+        return begin() + m_size;
+    }
+
+    const Entry * end() const noexcept
+    {
+        return begin() + m_size;
+    }
+
+    template <class K, class... Args>
+    Entry & emplace(K && key, Args &&... args)
+    {
+        Entry * entry = new (m_storage + m_size * sizeof(Entry)) Entry(std::piecewise_construct,
+                                                                        std::forward_as_tuple(std::forward<K>(key)),
+                                                                        std::forward_as_tuple(std::forward<Args>(args)...));
+        ++m_size;
+        return *entry;
+    }
+
+    // the last entry takes the place of the erased one
+    void erase(Entry * entry)
+    {
+        Entry * last = end() - 1;
+        if (entry != last) {
+            // assigned rather than destroyed and rebuilt, so a throwing move leaves a live entry behind
+            *entry = std::move(*last);
+        }
+        last->~Entry();
+        --m_size;
+    }
+
+    void clear() noexcept
+    {
+        for (Entry & entry : *this) {
+            entry.~Entry();
+        }
+        m_size = 0;
+    }
+
+private:
+    alignas(Entry) unsigned char m_storage[Capacity * sizeof(Entry)];
+    std::size_t m_size = 0;
+};
+
+// Read-only layout: entries are stored densely, a minimal-ish perfect hash (hash and displace)
+// maps every key to a 32-bit index of its entry, so a lookup is one seed load, one index load and
+// one key comparison.
+template <class Key, class Value>
+class PerfectHashTable
+{
+public:
+    using Entry = std::pair<Key, Value>;
+
+    PerfectHashTable() = default;
+
+    // returns false if some keys cannot be separated, i.e. they have equal hash values
+    template <class Hash>
+    bool build(std::vector<Entry> && entries, const Hash & hash)
+    {
+        // indices are 32-bit, and slots counts have to stay below 2^32 as well
+        if (entries.size() >= m_npos / 2) {
+            return false;
+        }
+        std::vector<std::uint64_t> hashes;
+        hashes.reserve(entries.size());
+        for (const Entry & entry : entries) {
+            hashes.push_back(mix(hash(entry.first)));
+        }
+        // grouping keys by bucket, with 4 keys per bucket on average
+        const std::size_t bucket_count = std::max<std::size_t>(1, entries.size() / 4);
+        std::vector<std::uint32_t> bucket_start(bucket_count + 1);
+        for (const std::uint64_t h : hashes) {
+            ++bucket_start[reduce(h, bucket_count) + 1];
+        }
+        for (std::size_t b = 0; b < bucket_count; ++b) {
+            bucket_start[b + 1] += bucket_start[b];
+        }
+        std::vector<std::uint32_t> bucket_keys(entries.size());
+        {
+            std::vector<std::uint32_t> fill(bucket_start.begin(), bucket_start.end() - 1);
+            for (std::size_t i = 0; i < hashes.size(); ++i) {
+                bucket_keys[fill[reduce(hashes[i], bucket_count)]++] = static_cast<std::uint32_t>(i);
+            }
+        }
+        std::vector<std::uint32_t> order(bucket_count);
+        for (std::size_t b = 0; b < bucket_count; ++b) {
+            order[b] = static_cast<std::uint32_t>(b);
+        }
+        std::stable_sort(order.begin(), order.end(), [&bucket_start](const std::uint32_t lhs, const std::uint32_t rhs) {
+            return bucket_start[lhs + 1] - bucket_start[lhs] > bucket_start[rhs + 1] - bucket_start[rhs];
+        });
+
+        // placing the largest buckets first; on failure there is more room on the next attempt
+        for (std::size_t slot_count = entries.size() + entries.size() / 16 + 1, attempt = 0; attempt < 4; ++attempt, slot_count += slot_count / 4) {
+            if (place(hashes, bucket_start, bucket_keys, order, slot_count)) {
+                m_entries = std::move(entries);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_entries.size();
+    }
+
+    std::vector<Entry> & entries() noexcept
+    {
+        return m_entries;
+    }
+
+    const std::vector<Entry> & entries() const noexcept
+    {
+        return m_entries;
+    }
+
+    template <class Hash, class Equal>
+    const Entry * find(const Key & key, const Hash & hash, const Equal & equal) const
+    {
+        if (m_entries.empty()) {
+            return nullptr;
+        }
+        const std::uint64_t h = mix(hash(key));
+        const std::uint32_t index = m_slots[slot(h, m_seeds[reduce(h, m_seeds.size())], m_slots.size())];
+        if (index != m_npos && equal(m_entries[index].first, key)) {
+            return &m_entries[index];
+        }
+        return nullptr;
+    }
+
+private:
+    static constexpr std::uint32_t m_npos = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::uint32_t m_max_seed = 1 << 16;
+
+    std::vector<Entry> m_entries;
+    std::vector<std::uint32_t> m_seeds; // per bucket
+    std::vector<std::uint32_t> m_slots; // entry index or m_npos
+
+    static std::uint64_t mix(std::uint64_t x) noexcept
+    {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    // maps `x` to [0, n) by multiplying its high half, `n` is below 2^32
+    static std::size_t reduce(const std::uint64_t x, const std::size_t n) noexcept
+    {
+        return static_cast<std::size_t>(((x >> 32) * n) >> 32);
+    }
+
+    static std::size_t slot(const std::uint64_t h, const std::uint32_t seed, const std::size_t slot_count) noexcept
+    {
+        return reduce(mix(h ^ ((seed + 1) * 0x9e3779b97f4a7c15ULL)), slot_count);
+    }
+
+    bool place(const std::vector<std::uint64_t> & hashes,
+               const std::vector<std::uint32_t> & bucket_start,
+               const std::vector<std::uint32_t> & bucket_keys,
+               const std::vector<std::uint32_t> & order,
+               const std::size_t slot_count)
+    {
+        m_seeds.assign(bucket_start.size() - 1, 0);
+        m_slots.assign(slot_count, m_npos);
+        std::vector<std::size_t> taken;
+        for (const std::uint32_t b : order) {
+            const std::uint32_t first = bucket_start[b];
+            const std::uint32_t last = bucket_start[b + 1];
+            if (first == last) {
+                break;
+            }
+            std::uint32_t seed = 0;
+            for (; seed < m_max_seed; ++seed) {
+                taken.clear();
+                for (std::uint32_t k = first; k < last; ++k) {
+                    const std::size_t s = slot(hashes[bucket_keys[k]], seed, slot_count);
+                    if (m_slots[s] != m_npos) {
+                        break;
+                    }
+                    m_slots[s] = bucket_keys[k];
+                    taken.push_back(s);
+                }
+                if (taken.size() == last - first) {
+                    break;
+                }
+                for (const std::size_t s : taken) {
+                    m_slots[s] = m_npos;
+                }
+            }
+            if (seed == m_max_seed) {
+                return false;
+            }
+            m_seeds[b] = seed;
+        }
+        return true;
+    }
+};
+
+} // namespace adaptive_details
+
+// Map changing its layout with its size and workload:
+//   Inline - up to MigrationPolicy::inline_capacity entries stored in the object itself, linear search,
+//   Table  - open addressing `HashMap`,
+//   Frozen - read-only dense entries behind a perfect hash, entered via `freeze()`, or via
+//            `freeze_if_read_mostly()` when MigrationPolicy::to_frozen() says so; any modification
+//            thaws it back into a table.
+// Lookups never change the layout. Entries are visited with `for_each`, pointers to values stay valid
+// until the next modification, freezing included.
+template <class Key,
+          class Value,
+          class Hash = std::hash<Key>,
+          class Equal = std::equal_to<Key>,
+          class MigrationPolicy = DefaultMigrationPolicy>
+class AdaptiveHashMap : private Hash
+    , private Equal
+{
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+
+    enum class Representation
+    {
+        Inline,
+        Table,
+        Frozen
+    };
+
+private:
+    using Inline = adaptive_details::InlineArray<Key, Value, MigrationPolicy::inline_capacity>;
+    using Table = HashMap<Key, Value, LinearProbing, Hash, Equal>;
+    using Frozen = adaptive_details::PerfectHashTable<Key, Value>;
+
+    std::variant<Inline, Table, Frozen> m_data;
+    size_type m_lookups = 0; // since the last modification
+
+public:
+    explicit AdaptiveHashMap(const hasher & hash = hasher(), const key_equal & equal = key_equal())
+        : hasher(hash)
+        , key_equal(equal)
+    {
+    }
+
+    Representation representation() const noexcept
+    {
+        return static_cast<Representation>(m_data.index());
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    size_type size() const
+    {
+        return std::visit([](const auto & data) -> size_type { return data.size(); }, m_data);
+    }
+
+    void clear()
+    {
+        m_data.template emplace<Inline>();
+        m_lookups = 0;
+    }
+
+    void reserve(const size_type count)
+    {
+        if (count > MigrationPolicy::inline_capacity) {
+            to_table().reserve(count);
+        }
+    }
+
+    // non-const lookups are counted for `freeze_if_read_mostly()`
+    Value * find(const key_type & key)
+    {
+        ++m_lookups;
+        return const_cast<Value *>(std::as_const(*this).find(key));
+    }
+
+    const Value * find(const key_type & key) const
+    {
+        switch (representation()) {
+        case Representation::Inline:
+            for (const auto & entry : std::get<Inline>(m_data)) {
+                if (equal(entry.first, key)) {
+                    return &entry.second;
+                }
+            }
+            return nullptr;
+        case Representation::Table: {
+            const Table & table = std::get<Table>(m_data);
+            const auto it = table.find(key);
+            return it != table.end() ? &it->second : nullptr;
+        }
+        case Representation::Frozen: {
+            const auto * entry = std::get<Frozen>(m_data).find(key, static_cast<const hasher &>(*this), static_cast<const key_equal &>(*this));
+            return entry != nullptr ? &entry->second : nullptr;
+        }
+        }
+        return nullptr;
+    }
+
+    bool contains(const key_type & key) const
+    {
+        return find(key) != nullptr;
+    }
+
+    size_type count(const key_type & key) const
+    {
+        return contains(key) ? 1 : 0;
+    }
+
+    Value & at(const key_type & key)
+    {
+        if (Value * value = find(key)) {
+            return *value;
+        }
+        throw std::out_of_range("AdaptiveHashMap::at");
+    }
+
+    const Value & at(const key_type & key) const
+    {
+        if (const Value * value = find(key)) {
+            return *value;
+        }
+        throw std::out_of_range("AdaptiveHashMap::at");
+    }
+
+    template <class... Args>
+    std::pair<Value *, bool> try_emplace(const key_type & key, Args &&... args)
+    {
+        if (frozen()) {
+            if (const Value * value = find(key)) {
+                return {const_cast<Value *>(value), false};
+            }
+        }
+        modified();
+        if (auto * array = std::get_if<Inline>(&m_data)) {
+            for (auto & entry : *array) {
+                if (equal(entry.first, key)) {
+                    return {&entry.second, false};
+                }
+            }
+            if (!array->full()) {
+                return {&array->emplace(key, std::forward<Args>(args)...).second, true};
+            }
+        }
+        auto [it, inserted] = to_table().try_emplace(key, std::forward<Args>(args)...);
+        return {&it->second, inserted};
+    }
+
+    template <class M>
+    std::pair<Value *, bool> insert_or_assign(const key_type & key, M && value)
+    {
+        auto result = try_emplace(key, std::forward<M>(value));
+        if (!result.second) {
+            *result.first = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    Value & operator[](const key_type & key)
+    {
+        return *try_emplace(key).first;
+    }
+
+    size_type erase(const key_type & key)
+    {
+        if (!contains(key)) {
+            return 0;
+        }
+        modified();
+        if (auto * array = std::get_if<Inline>(&m_data)) {
+            for (auto & entry : *array) {
+                if (equal(entry.first, key)) {
+                    array->erase(&entry);
+                    break;
+                }
+            }
+            return 1;
+        }
+        Table & table = to_table();
+        table.erase(key);
+        if (table.size() <= MigrationPolicy::inline_capacity && MigrationPolicy::to_inline(table.size())) {
+            Inline array;
+            for (auto & entry : table) {
+                array.emplace(entry.first, std::move(entry.second));
+            }
+            m_data = std::move(array);
+        }
+        return 1;
+    }
+
+    // converts the map into the read-only perfect hash layout; returns false and stays a table
+    // if some keys have equal hash values and cannot be separated
+    bool freeze()
+    {
+        if (frozen()) {
+            return true;
+        }
+        std::vector<std::pair<Key, Value>> entries;
+        entries.reserve(size());
+        for_each([&entries](const Key & key, Value & value) {
+            entries.emplace_back(key, std::move(value));
+        });
+        Frozen layout;
+        const hasher & hash = *this;
+        if (!layout.build(std::move(entries), hash)) {
+            // entries are still there, build() does not consume them on failure
+            Table table(entries.size(), hash, *this);
+            for (auto & entry : entries) {
+                table.try_emplace(std::move(entry.first), std::move(entry.second));
+            }
+            m_data = std::move(table);
+            return false;
+        }
+        m_data = std::move(layout);
+        return true;
+    }
+
+    // freezes a table looked up often enough since its last modification, see MigrationPolicy::to_frozen();
+    // meant to be called between phases of a workload, returns whether the map is frozen
+    bool freeze_if_read_mostly()
+    {
+        if (const auto * table = std::get_if<Table>(&m_data); table != nullptr && MigrationPolicy::to_frozen(table->size(), m_lookups)) {
+            return freeze();
+        }
+        return frozen();
+    }
+
+    bool frozen() const noexcept
+    {
+        return representation() == Representation::Frozen;
+    }
+
+    // `f(const Key &, Value &)`
+    template <class F>
+    void for_each(F && f)
+    {
+        std::visit([&f](auto & data) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(data)>, Frozen>) {
+                for (auto & entry : data.entries()) {
+                    f(static_cast<const Key &>(entry.first), entry.second);
+                }
+            }
+            else {
+                for (auto & entry : data) {
+                    f(static_cast<const Key &>(entry.first), entry.second);
+                }
+            }
+        },
+                   m_data);
+    }
+
+    // `f(const Key &, const Value &)`
+    template <class F>
+    void for_each(F && f) const
+    {
+        const_cast<AdaptiveHashMap &>(*this).for_each([&f](const Key & key, const Value & value) { f(key, value); });
+    }
+
+private:
+    bool equal(const key_type & lhs, const key_type & rhs) const
+    {
+        return key_equal::operator()(lhs, rhs);
+    }
+
+    void modified() noexcept
+    {
+        m_lookups = 0;
+    }
+
+    // converts the inline or frozen representation into a hash table
+    Table & to_table()
+    {
+        if (auto * table = std::get_if<Table>(&m_data)) {
+            return *table;
+        }
+        Table table(size(), *this, *this);
+        for_each([&table](const Key & key, Value & value) {
+            table.try_emplace(key, std::move(value));
+        });
+        return m_data.template emplace<Table>(std::move(table));
+    }
+};
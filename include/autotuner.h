@@ -0,0 +1,208 @@
+#pragma once
+
+#include "hash_functions.h"
+#include "hash_map.h"
+#include "tracing_hash_map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Evaluates every combination of collision policy, range hash, hash function and maximal load factor
+// on a key sample or a recorded trace, and reports the fastest and the smallest configuration.
+//
+//     const TuningReport report = autotune<std::uint64_t>(keys);
+//     report.print(std::cout);
+//     std::cout << report.fastest().type_name("std::uint64_t", "Value");
+
+struct TuningResult
+{
+    std::string collision_policy;
+    std::string range_hash;
+    std::string hash; // with `Key` standing for the key type
+    unsigned max_load_percent = 0;
+
+    double ns_per_op = 0;           // best of the repetitions
+    std::size_t memory_bytes = 0;   // MemoryUsage::total_bytes() at the end of the workload
+    double probes_per_lookup = 0;
+    std::size_t rehashes = 0;
+
+    std::string type_name(const std::string & key, const std::string & value) const
+    {
+        std::string h = hash;
+        for (std::size_t pos = 0; (pos = h.find("Key", pos)) != std::string::npos; pos += key.size()) {
+            h.replace(pos, 3, key);
+        }
+        return "HashMap<" + key + ", " + value + ", " + collision_policy + ", " + h + ", std::equal_to<" + key + ">, " +
+                range_hash + ", LoadFactorRehashPolicy<" + std::to_string(max_load_percent) + ">>";
+    }
+};
+
+struct TuningReport
+{
+    std::vector<TuningResult> results;
+
+    const TuningResult & fastest() const
+    {
+        return *std::min_element(results.begin(), results.end(), [](const TuningResult & lhs, const TuningResult & rhs) {
+            return lhs.ns_per_op < rhs.ns_per_op;
+        });
+    }
+
+    // ties on memory are resolved by speed
+    const TuningResult & smallest() const
+    {
+        return *std::min_element(results.begin(), results.end(), [](const TuningResult & lhs, const TuningResult & rhs) {
+            return lhs.memory_bytes != rhs.memory_bytes ? lhs.memory_bytes < rhs.memory_bytes : lhs.ns_per_op < rhs.ns_per_op;
+        });
+    }
+
+    void print(std::ostream & out) const
+    {
+        std::vector<TuningResult> sorted = results;
+        std::sort(sorted.begin(), sorted.end(), [](const TuningResult & lhs, const TuningResult & rhs) {
+            return lhs.ns_per_op < rhs.ns_per_op;
+        });
+        out << std::left << std::setw(18) << "collision" << std::setw(24) << "range hash" << std::setw(30) << "hash"
+            << std::right << std::setw(6) << "load" << std::setw(10) << "ns/op" << std::setw(14) << "bytes"
+            << std::setw(12) << "probes/op" << std::setw(10) << "rehashes" << '\n';
+        for (const TuningResult & r : sorted) {
+            out << std::left << std::setw(18) << r.collision_policy << std::setw(24) << r.range_hash << std::setw(30) << r.hash
+                << std::right << std::setw(6) << r.max_load_percent
+                << std::fixed << std::setprecision(2) << std::setw(10) << r.ns_per_op
+                << std::setw(14) << r.memory_bytes << std::setw(12) << r.probes_per_lookup
+                << std::setw(10) << r.rehashes << '\n';
+        }
+    }
+};
+
+namespace autotuner_details {
+
+template <class Key, class Value, class CollisionPolicy, class Hash, class RangeHash, unsigned MaxLoadPercent, class StatsPolicy = NoStats>
+using Map = HashMap<Key, Value, CollisionPolicy, Hash, std::equal_to<Key>, RangeHash, LoadFactorRehashPolicy<MaxLoadPercent>, NoAccessTracking, NoFilter, StatsPolicy>;
+
+template <class Key, class Value, class Workload>
+class Tuner
+{
+public:
+    Tuner(const Workload & workload, const std::size_t operations, const unsigned repetitions)
+        : m_workload(workload)
+        , m_operations(operations)
+        , m_repetitions(std::max(1u, repetitions))
+    {
+    }
+
+    template <class BaseHash>
+    TuningReport run(const std::string & base_hash_name)
+    {
+        TuningReport report;
+        collision<LinearProbing, BaseHash>(report, "LinearProbing", base_hash_name);
+        collision<QuadraticProbing, BaseHash>(report, "QuadraticProbing", base_hash_name);
+        return report;
+    }
+
+private:
+    const Workload & m_workload;
+    const std::size_t m_operations;
+    const unsigned m_repetitions;
+
+    template <class CollisionPolicy, class BaseHash>
+    void collision(TuningReport & report, const std::string & collision_name, const std::string & base_hash_name)
+    {
+        range<CollisionPolicy, BaseHash, MaskRangeHashing>(report, collision_name, "MaskRangeHashing", base_hash_name);
+        range<CollisionPolicy, BaseHash, FibonacciRangeHashing>(report, collision_name, "FibonacciRangeHashing", base_hash_name);
+    }
+
+    template <class CollisionPolicy, class BaseHash, class RangeHash>
+    void range(TuningReport & report, const std::string & collision_name, const std::string & range_name, const std::string & base_hash_name)
+    {
+        TuningResult base;
+        base.collision_policy = collision_name;
+        base.range_hash = range_name;
+        base.hash = base_hash_name;
+        load<CollisionPolicy, BaseHash, RangeHash>(report, base);
+        TuningResult mixed = base;
+        mixed.hash = "MixHash<Key, " + base_hash_name + ">";
+        load<CollisionPolicy, MixHash<Key, BaseHash>, RangeHash>(report, mixed);
+    }
+
+    template <class CollisionPolicy, class Hash, class RangeHash>
+    void load(TuningReport & report, const TuningResult & config)
+    {
+        evaluate<CollisionPolicy, Hash, RangeHash, 50>(report, config);
+        evaluate<CollisionPolicy, Hash, RangeHash, 70>(report, config);
+        evaluate<CollisionPolicy, Hash, RangeHash, 85>(report, config);
+    }
+
+    template <class CollisionPolicy, class Hash, class RangeHash, unsigned MaxLoadPercent>
+    void evaluate(TuningReport & report, TuningResult result)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        result.max_load_percent = MaxLoadPercent;
+        Clock::duration best = Clock::duration::max();
+        for (unsigned i = 0; i < m_repetitions; ++i) {
+            Map<Key, Value, CollisionPolicy, Hash, RangeHash, MaxLoadPercent> map;
+            const Clock::time_point start = Clock::now();
+            m_workload(map);
+            best = std::min(best, Clock::now() - start);
+            result.memory_bytes = map.memory_usage().total_bytes();
+        }
+        result.ns_per_op = 1e9 * std::chrono::duration<double>(best).count() / std::max<std::size_t>(m_operations, 1);
+
+        Map<Key, Value, CollisionPolicy, Hash, RangeHash, MaxLoadPercent, CountingStats> counted;
+        m_workload(counted);
+        result.probes_per_lookup = counted.instrumentation().counters().probes_per_lookup();
+        result.rehashes = counted.instrumentation().counters().rehashes;
+        report.results.push_back(std::move(result));
+    }
+};
+
+} // namespace autotuner_details
+
+// Workload: `keys` are inserted in the given order, then all of them and all of `missing` are looked up
+// in a shuffled order. `hash_name` names `Hash` in the reported type names.
+template <class Key, class Value = std::uint64_t, class Hash = std::hash<Key>>
+TuningReport autotune(const std::vector<Key> & keys,
+                      const std::vector<Key> & missing = {},
+                      const unsigned repetitions = 3,
+                      const std::string & hash_name = "std::hash<Key>")
+{
+    std::vector<const Key *> lookups;
+    for (const Key & key : keys) {
+        lookups.push_back(&key);
+    }
+    for (const Key & key : missing) {
+        lookups.push_back(&key);
+    }
+    std::shuffle(lookups.begin(), lookups.end(), std::mt19937_64{keys.size()});
+
+    const auto workload = [&](auto & map) {
+        for (const Key & key : keys) {
+            map.try_emplace(key);
+        }
+        std::size_t found = 0;
+        for (const Key * key : lookups) {
+            found += map.count(*key);
+        }
+        return found;
+    };
+    autotuner_details::Tuner<Key, Value, decltype(workload)> tuner(workload, keys.size() + lookups.size(), repetitions);
+    return tuner.template run<Hash>(hash_name);
+}
+
+// Workload: the trace recorded by `TracingHashMap`, keyed by its tokens which are hash values already,
+// so the base hash is identity
+inline TuningReport autotune(const std::vector<TraceRecord> & trace, const unsigned repetitions = 3)
+{
+    const auto workload = [&](auto & map) {
+        return replay_trace(map, trace);
+    };
+    autotuner_details::Tuner<std::uint64_t, std::uint64_t, decltype(workload)> tuner(workload, trace.size(), repetitions);
+    return tuner.template run<IdentityHash>("IdentityHash");
+}
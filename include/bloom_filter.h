@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Blocked Bloom filter to be used as a `FilterPolicy` of `HashMap` / `HashSet`:
+// every key sets 3 bits of a single 64-bit word, so a negative lookup costs one memory access
+// to a structure much smaller than the table itself.
+// Erased keys are not removed from the filter (they only cause false positives),
+// the filter is rebuilt from scratch on every rehash.
+template <std::size_t BitsPerBucket = 4>
+class BlockedBloomFilter
+{
+public:
+    static constexpr bool enabled = true;
+
+    void reset_filter(const std::size_t bucket_count)
+    {
+        std::size_t words = 1;
+        while (words * 64 < bucket_count * BitsPerBucket) {
+            words <<= 1;
+        }
+        m_words.assign(words, 0);
+    }
+
+    void add_to_filter(const std::size_t hash) noexcept
+    {
+        const std::uint64_t x = mix(hash);
+        m_words[word(x)] |= mask(x);
+    }
+
+    bool may_contain(const std::size_t hash) const noexcept
+    {
+        const std::uint64_t x = mix(hash);
+        const std::uint64_t bits = mask(x);
+        return (m_words[word(x)] & bits) == bits;
+    }
+
+    std::size_t filter_bytes() const noexcept
+    {
+        return m_words.size() * sizeof(std::uint64_t);
+    }
+
+private:
+    std::vector<std::uint64_t> m_words;
+
+    // user hashes are often identity functions, so spread them before picking the bits
+    static constexpr std::uint64_t mix(std::uint64_t x) noexcept
+    {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    std::size_t word(const std::uint64_t x) const noexcept
+    {
+        return (x >> 32) & (m_words.size() - 1);
+    }
+
+    static constexpr std::uint64_t mask(const std::uint64_t x) noexcept
+    {
+        return (1ULL << (x & 63)) | (1ULL << ((x >> 6) & 63)) | (1ULL << ((x >> 12) & 63));
+    }
+};
@@ -0,0 +1,468 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace compact_hash_set_details {
+constexpr std::uint64_t multiplicative_inverse(const std::uint64_t a) noexcept
+{
+    std::uint64_t x = a;
+    for (int i = 0; i < 5; ++i) {
+        x *= 2 - a * x;
+    }
+    return x;
+}
+
+constexpr std::uint64_t first_multiplier = 0xff51afd7ed558ccdULL;
+constexpr std::uint64_t second_multiplier = 0xc4ceb9fe1a85ec53ULL;
+
+// invertible mixing function: the key can be restored from its hash,
+// so the set does not need to store keys themselves
+constexpr std::uint64_t permute(std::uint64_t x) noexcept
+{
+    x ^= x >> 32;
+    x *= first_multiplier;
+    x ^= x >> 32;
+    x *= second_multiplier;
+    x ^= x >> 32;
+    return x;
+}
+
+constexpr std::uint64_t restore(std::uint64_t x) noexcept
+{
+    x ^= x >> 32;
+    x *= multiplicative_inverse(second_multiplier);
+    x ^= x >> 32;
+    x *= multiplicative_inverse(first_multiplier);
+    x ^= x >> 32;
+    return x;
+}
+} // namespace compact_hash_set_details
+
+// Set of integers storing only `64 - log2(bucket_count())` remainder bits of every key plus
+// an 8-bit distance from its home slot: the quotient (upper bits of the permuted key) is implied
+// by the home slot. Collisions are resolved with Robin Hood linear probing and backward shift
+// deletion, so there are no tombstones.
+template <class Key = std::uint64_t>
+class CompactHashSet
+{
+    static_assert(std::is_integral_v<Key> && sizeof(Key) <= sizeof(std::uint64_t), "CompactHashSet supports integer keys only");
+
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+private:
+    static constexpr unsigned m_dist_bits = 8;
+    static constexpr std::uint64_t m_max_dist = (1ULL << m_dist_bits) - 2;
+    static constexpr unsigned m_min_quotient_bits = 64 - 56;
+    // doublings allowed on top of the size needed by the load when a distance does not fit into its slot,
+    // so that keys sharing long hash prefixes cannot grow the table without bound
+    static constexpr unsigned m_max_overflow_growth = 4;
+
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = CompactHashSet::value_type;
+        using difference_type = CompactHashSet::difference_type;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator() = default;
+
+        reference operator*() const
+        {
+            return static_cast<value_type>(compact_hash_set_details::restore(m_set->hash_at(m_pos)));
+        }
+
+        Iterator & operator++()
+        {
+            m_pos = m_set->next_used(m_pos + 1);
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            auto tmp = *this;
+            operator++();
+            return tmp;
+        }
+
+        friend bool operator==(const Iterator & lhs, const Iterator & rhs)
+        {
+            return lhs.m_pos == rhs.m_pos && lhs.m_set == rhs.m_set;
+        }
+
+        friend bool operator!=(const Iterator & lhs, const Iterator & rhs)
+        {
+            return !(lhs == rhs);
+        }
+
+    private:
+        friend class CompactHashSet;
+
+        size_type m_pos;
+        const CompactHashSet * m_set;
+
+        constexpr Iterator(const size_type pos, const CompactHashSet * set) noexcept
+            : m_pos(pos)
+            , m_set(set)
+        {
+        }
+    };
+
+    std::vector<std::uint64_t> m_words;
+
+    size_type m_size = 0;
+    unsigned m_quotient_bits = m_min_quotient_bits;
+
+public:
+    using iterator = Iterator;
+    using const_iterator = Iterator;
+
+    explicit CompactHashSet(size_type expected_max_size = 0)
+    {
+        allocate(quotient_bits_for(expected_max_size));
+    }
+
+    template <class InputIt>
+    CompactHashSet(InputIt first, InputIt last, size_type expected_max_size = 0)
+        : CompactHashSet(expected_max_size)
+    {
+        insert(first, last);
+    }
+
+    CompactHashSet(std::initializer_list<value_type> init, size_type expected_max_size = 0)
+        : CompactHashSet(init.begin(), init.end(), std::max(expected_max_size, init.size()))
+    {
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return cbegin();
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return {next_used(0), this};
+    }
+
+    const_iterator end() const noexcept
+    {
+        return cend();
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return {bucket_count(), this};
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    void clear()
+    {
+        std::fill(m_words.begin(), m_words.end(), 0);
+        m_size = 0;
+    }
+
+    bool insert(const value_type key)
+    {
+        const std::uint64_t hash = compact_hash_set_details::permute(static_cast<std::uint64_t>(key));
+        if (search(hash) != bucket_count()) {
+            return false;
+        }
+        if ((size() + 1) * 8 > bucket_count() * 7) {
+            std::vector<std::uint64_t> hashes = stored_hashes();
+            hashes.push_back(hash);
+            rebuild_with(hashes, hash, m_quotient_bits + 1);
+        }
+        else if (std::uint64_t displaced = hash; !place(displaced)) {
+            std::vector<std::uint64_t> hashes = stored_hashes();
+            hashes.push_back(displaced);
+            rebuild_with(hashes, hash, m_quotient_bits + 1);
+        }
+        ++m_size;
+        return true;
+    }
+
+    template <class InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        for (auto it = first; it != last; ++it) {
+            insert(*it);
+        }
+    }
+
+    size_type erase(const value_type key)
+    {
+        size_type pos = search(compact_hash_set_details::permute(static_cast<std::uint64_t>(key)));
+        if (pos == bucket_count()) {
+            return 0;
+        }
+        for (size_type next = wrap(pos + 1);; pos = next, next = wrap(next + 1)) {
+            const std::uint64_t slot = get(next);
+            if (dist(slot) == 0 || dist(slot) == 1) {
+                break;
+            }
+            set(pos, slot - 1);
+        }
+        set(pos, 0);
+        --m_size;
+        return 1;
+    }
+
+    void swap(CompactHashSet & other) noexcept
+    {
+        std::swap(m_words, other.m_words);
+        std::swap(m_size, other.m_size);
+        std::swap(m_quotient_bits, other.m_quotient_bits);
+    }
+
+    size_type count(const value_type key) const
+    {
+        return contains(key);
+    }
+
+    const_iterator find(const value_type key) const
+    {
+        return {search(compact_hash_set_details::permute(static_cast<std::uint64_t>(key))), this};
+    }
+
+    bool contains(const value_type key) const
+    {
+        return find(key) != cend();
+    }
+
+    size_type bucket_count() const
+    {
+        return size_type{1} << m_quotient_bits;
+    }
+
+    float load_factor() const
+    {
+        return 1.0f * size() / bucket_count();
+    }
+
+    float max_load_factor() const
+    {
+        return 0.875f;
+    }
+
+    // only a hint: the current table is kept if the keys do not fit a table of the requested size
+    void reserve(const size_type count)
+    {
+        if (const unsigned bits = quotient_bits_for(count); bits > m_quotient_bits) {
+            const unsigned old_bits = m_quotient_bits;
+            const std::vector<std::uint64_t> hashes = stored_hashes();
+            if (!rebuild(hashes, bits)) {
+                rebuild(hashes, old_bits);
+            }
+        }
+    }
+
+    // number of bits stored per slot
+    size_type slot_bits() const
+    {
+        return remainder_bits() + m_dist_bits;
+    }
+
+    size_type memory_bytes() const
+    {
+        return sizeof(*this) + m_words.capacity() * sizeof(std::uint64_t);
+    }
+
+    friend bool operator==(const CompactHashSet & lhs, const CompactHashSet & rhs)
+    {
+        if (lhs.size() != rhs.size()) {
+            return false;
+        }
+        for (const auto key : lhs) {
+            if (!rhs.contains(key)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool operator!=(const CompactHashSet & lhs, const CompactHashSet & rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+private:
+    // slot layout: remainder in upper bits, (distance + 1) in the lower `m_dist_bits` bits, 0 is an empty slot
+    static constexpr std::uint64_t dist(const std::uint64_t slot) noexcept
+    {
+        return slot & ((1ULL << m_dist_bits) - 1);
+    }
+
+    static constexpr std::uint64_t remainder(const std::uint64_t slot) noexcept
+    {
+        return slot >> m_dist_bits;
+    }
+
+    static constexpr std::uint64_t make_slot(const std::uint64_t remainder, const std::uint64_t dist) noexcept
+    {
+        return (remainder << m_dist_bits) | (dist + 1);
+    }
+
+    static unsigned quotient_bits_for(const size_type expected_max_size) noexcept
+    {
+        unsigned bits = m_min_quotient_bits;
+        while ((size_type{1} << bits) * 7 < expected_max_size * 8) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    unsigned remainder_bits() const noexcept
+    {
+        return 64 - m_quotient_bits;
+    }
+
+    size_type wrap(const size_type pos) const noexcept
+    {
+        return pos & (bucket_count() - 1);
+    }
+
+    std::uint64_t get(const size_type pos) const noexcept
+    {
+        const size_type width = slot_bits();
+        const size_type bit = pos * width;
+        const size_type word = bit / 64;
+        const size_type offset = bit % 64;
+        std::uint64_t value = m_words[word] >> offset;
+        if (offset + width > 64) {
+            value |= m_words[word + 1] << (64 - offset);
+        }
+        return width == 64 ? value : value & ((1ULL << width) - 1);
+    }
+
+    void set(const size_type pos, const std::uint64_t value) noexcept
+    {
+        const size_type width = slot_bits();
+        const size_type bit = pos * width;
+        const size_type word = bit / 64;
+        const size_type offset = bit % 64;
+        const std::uint64_t mask = width == 64 ? ~0ULL : (1ULL << width) - 1;
+        m_words[word] = (m_words[word] & ~(mask << offset)) | (value << offset);
+        if (offset + width > 64) {
+            const size_type shift = 64 - offset;
+            m_words[word + 1] = (m_words[word + 1] & ~(mask >> shift)) | (value >> shift);
+        }
+    }
+
+    std::uint64_t hash_at(const size_type pos) const noexcept
+    {
+        const std::uint64_t slot = get(pos);
+        const std::uint64_t home = wrap(pos - (dist(slot) - 1));
+        return (home << remainder_bits()) | remainder(slot);
+    }
+
+    size_type next_used(size_type pos) const noexcept
+    {
+        while (pos < bucket_count() && get(pos) == 0) {
+            ++pos;
+        }
+        return pos;
+    }
+
+    size_type search(const std::uint64_t hash) const noexcept
+    {
+        const std::uint64_t rem = hash & ((1ULL << remainder_bits()) - 1);
+        size_type pos = hash >> remainder_bits();
+        for (std::uint64_t d = 1;; ++d, pos = wrap(pos + 1)) {
+            const std::uint64_t slot = get(pos);
+            if (dist(slot) < d) {
+                return bucket_count();
+            }
+            if (dist(slot) == d && remainder(slot) == rem) {
+                return pos;
+            }
+        }
+    }
+
+    // Robin Hood insertion; if the distance of the element carried along does not fit into its slot,
+    // `hash` is set to that element, which is no longer in the table, and false is returned
+    bool place(std::uint64_t & hash)
+    {
+        std::uint64_t rem = hash & ((1ULL << remainder_bits()) - 1);
+        size_type pos = hash >> remainder_bits();
+        for (std::uint64_t d = 0;; ++d, pos = wrap(pos + 1)) {
+            if (d > m_max_dist) {
+                hash = (wrap(pos - d) << remainder_bits()) | rem;
+                return false;
+            }
+            const std::uint64_t slot = get(pos);
+            if (slot == 0) {
+                set(pos, make_slot(rem, d));
+                return true;
+            }
+            if (dist(slot) - 1 < d) {
+                set(pos, make_slot(rem, d));
+                rem = remainder(slot);
+                d = dist(slot) - 1;
+            }
+        }
+    }
+
+    void allocate(const unsigned quotient_bits)
+    {
+        m_quotient_bits = quotient_bits;
+        m_words.assign((bucket_count() * slot_bits() + 63) / 64 + 1, 0);
+    }
+
+    std::vector<std::uint64_t> stored_hashes() const
+    {
+        std::vector<std::uint64_t> hashes;
+        hashes.reserve(size() + 1);
+        for (size_type pos = next_used(0); pos < bucket_count(); pos = next_used(pos + 1)) {
+            hashes.push_back(hash_at(pos));
+        }
+        return hashes;
+    }
+
+    // places `hashes` into a new table of at least `quotient_bits`, doubling it while some distance does not fit
+    bool rebuild(const std::vector<std::uint64_t> & hashes, unsigned quotient_bits)
+    {
+        const unsigned max_bits = std::min(quotient_bits + m_max_overflow_growth, 63u);
+        for (; quotient_bits <= max_bits; ++quotient_bits) {
+            allocate(quotient_bits);
+            if (std::all_of(hashes.begin(), hashes.end(), [this](std::uint64_t hash) { return place(hash); })) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // rebuilds the table holding `hashes`, which include the new element `inserted`; if they do not fit,
+    // the table is restored without `inserted`: the previous keys fit the previous size, Robin Hood
+    // placement of a set does not depend on the insertion order
+    void rebuild_with(std::vector<std::uint64_t> & hashes, const std::uint64_t inserted, const unsigned quotient_bits)
+    {
+        const unsigned old_bits = m_quotient_bits;
+        if (!rebuild(hashes, quotient_bits)) {
+            hashes.erase(std::find(hashes.begin(), hashes.end(), inserted));
+            rebuild(hashes, old_bits);
+            throw std::length_error("CompactHashSet: too many keys share a hash prefix");
+        }
+    }
+};
@@ -0,0 +1,272 @@
+#pragma once
+
+#include "hash_functions.h"
+#include "hash_map.h"
+#include "parallel_details.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Aggregate functions of `HashAggregator`: `input_type` is the element type of the consumed column,
+// void for functions without one; `state_type` the per group result, starting as `init()`,
+// updated by the rows of the group and combined with the state of another partial aggregation by `merge`.
+
+template <class T, class State = T>
+struct Sum
+{
+    using input_type = T;
+    using state_type = State;
+
+    static constexpr state_type init() noexcept
+    {
+        return state_type{};
+    }
+
+    static void update(state_type & state, const input_type & value)
+    {
+        state += value;
+    }
+
+    static void merge(state_type & state, const state_type & other)
+    {
+        state += other;
+    }
+};
+
+struct Count
+{
+    using input_type = void;
+    using state_type = std::uint64_t;
+
+    static constexpr state_type init() noexcept
+    {
+        return 0;
+    }
+
+    static void update(state_type & state) noexcept
+    {
+        ++state;
+    }
+
+    static void merge(state_type & state, const state_type & other) noexcept
+    {
+        state += other;
+    }
+};
+
+template <class T>
+struct Min
+{
+    using input_type = T;
+    using state_type = T;
+
+    static constexpr state_type init() noexcept
+    {
+        return std::numeric_limits<T>::max();
+    }
+
+    static void update(state_type & state, const input_type & value)
+    {
+        state = std::min(state, value);
+    }
+
+    static void merge(state_type & state, const state_type & other)
+    {
+        update(state, other);
+    }
+};
+
+template <class T>
+struct Max
+{
+    using input_type = T;
+    using state_type = T;
+
+    static constexpr state_type init() noexcept
+    {
+        return std::numeric_limits<T>::lowest();
+    }
+
+    static void update(state_type & state, const input_type & value)
+    {
+        state = std::max(state, value);
+    }
+
+    static void merge(state_type & state, const state_type & other)
+    {
+        update(state, other);
+    }
+};
+
+// Group-by over column batches: `consume(keys, count, columns...)` takes one column per aggregate
+// function (nullptr for Count). Every batch of `BatchSize` rows is processed in three passes:
+// the home slots of all keys are prefetched (once the table outgrows the cache), every key is mapped
+// to its group number with a single `try_emplace` probe, then every aggregate runs over the batch as
+// a tight loop over its column. The states of a group are stored together, indexed by its number.
+//
+//     HashAggregator<std::uint32_t, Count, Sum<double>, Max<double>> rollup;
+//     rollup.consume(host.data(), host.size(), nullptr, latency.data(), latency.data());
+//     rollup.for_each([](std::uint32_t host, std::uint64_t requests, double total, double worst) { ... });
+template <class Key, class... Aggs>
+class HashAggregator
+{
+    static_assert(sizeof...(Aggs) > 0, "at least one aggregate function is required");
+
+    static constexpr std::size_t BatchSize = 256;
+    // smaller tables stay in cache, prefetching them would only hash every key twice
+    static constexpr std::size_t PrefetchBuckets = std::size_t{1} << 16;
+
+public:
+    using key_type = Key;
+    using size_type = std::size_t;
+    using group_type = std::uint32_t;
+    using result_type = std::tuple<typename Aggs::state_type...>;
+
+private:
+    HashMap<Key, group_type, LinearProbing, MixHash<Key>> m_groups;
+    std::vector<result_type> m_states; // by group number
+
+public:
+    // number of groups
+    size_type size() const noexcept
+    {
+        return m_groups.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return m_groups.empty();
+    }
+
+    void clear()
+    {
+        m_groups.clear();
+        m_states.clear();
+    }
+
+    void consume(const Key * keys, const size_type count, const typename Aggs::input_type *... columns)
+    {
+        group_type groups[BatchSize];
+        for (size_type begin = 0; begin < count; begin += BatchSize) {
+            const size_type rows = std::min(BatchSize, count - begin);
+            if (m_groups.bucket_count() >= PrefetchBuckets) {
+                for (size_type i = 0; i < rows; ++i) {
+                    m_groups.prefetch(keys[begin + i]);
+                }
+            }
+            for (size_type i = 0; i < rows; ++i) {
+                groups[i] = group(keys[begin + i]);
+                __builtin_prefetch(&m_states[groups[i]]);
+            }
+            update(std::index_sequence_for<Aggs...>(), groups, rows, advance(columns, begin)...);
+        }
+    }
+
+    // splits the rows between `threads` partial aggregators and merges them into this one;
+    // an exception thrown by one of them is rethrown here once all threads are done
+    void consume_parallel(const unsigned threads, const Key * keys, const size_type count, const typename Aggs::input_type *... columns)
+    {
+        const size_type workers = std::min<size_type>(std::max(threads, 1u), count / BatchSize + 1);
+        if (workers <= 1) {
+            consume(keys, count, columns...);
+            return;
+        }
+        std::vector<HashAggregator> partials(workers);
+        parallel_details::for_each(workers, threads, [&](const size_type w) {
+            const size_type begin = count * w / workers;
+            const size_type end = count * (w + 1) / workers;
+            partials[w].consume(keys + begin, end - begin, advance(columns, begin)...);
+        });
+        for (const HashAggregator & partial : partials) {
+            merge(partial);
+        }
+    }
+
+    // combines the groups of another partial aggregation into this one
+    void merge(const HashAggregator & other)
+    {
+        for (const auto & [key, other_group] : other.m_groups) {
+            merge_group(std::index_sequence_for<Aggs...>(), group(key), other, other_group);
+        }
+    }
+
+    bool contains(const key_type & key) const
+    {
+        return m_groups.contains(key);
+    }
+
+    result_type result(const key_type & key) const
+    {
+        const auto it = m_groups.find(key);
+        if (it == m_groups.end()) {
+            throw std::out_of_range("HashAggregator::result");
+        }
+        return m_states[it->second];
+    }
+
+    // `f(const Key &, const Aggs::state_type &...)` for every group
+    template <class F>
+    void for_each(F && f) const
+    {
+        for (const auto & [key, id] : m_groups) {
+            std::apply([&f, &key](const auto &... states) { f(key, states...); }, m_states[id]);
+        }
+    }
+
+private:
+    group_type group(const key_type & key)
+    {
+        const auto next = static_cast<group_type>(m_groups.size());
+        const auto [it, inserted] = m_groups.try_emplace(key, next);
+        if (inserted) {
+            m_states.emplace_back(Aggs::init()...);
+        }
+        return it->second;
+    }
+
+    template <class T>
+    static const T * advance(const T * column, const size_type rows) noexcept
+    {
+        if constexpr (std::is_void_v<T>) {
+            return column;
+        }
+        else {
+            return column != nullptr ? column + rows : nullptr;
+        }
+    }
+
+    template <std::size_t... I, class... Columns>
+    void update(std::index_sequence<I...>, const group_type * groups, const size_type rows, const Columns *... columns)
+    {
+        (update_column<I>(groups, rows, columns), ...);
+    }
+
+    template <std::size_t I, class Column>
+    void update_column(const group_type * groups, const size_type rows, const Column * column)
+    {
+        using Agg = std::tuple_element_t<I, std::tuple<Aggs...>>;
+        if constexpr (std::is_void_v<typename Agg::input_type>) {
+            for (size_type i = 0; i < rows; ++i) {
+                Agg::update(std::get<I>(m_states[groups[i]]));
+            }
+        }
+        else {
+            for (size_type i = 0; i < rows; ++i) {
+                Agg::update(std::get<I>(m_states[groups[i]]), column[i]);
+            }
+        }
+    }
+
+    template <std::size_t... I>
+    void merge_group(std::index_sequence<I...>, const group_type group, const HashAggregator & other, const group_type other_group)
+    {
+        (Aggs::merge(std::get<I>(m_states[group]), std::get<I>(other.m_states[other_group])), ...);
+    }
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Passes integer keys which already are hash values through unchanged
+struct IdentityHash
+{
+    std::size_t operator()(const std::uint64_t key) const noexcept
+    {
+        return static_cast<std::size_t>(key);
+    }
+};
+
+// Applies the murmur3 finalizer on top of `Hash`, so every bit of the result depends on every bit
+// of the inner hash; protects MaskRangeHashing from identity hashes of patterned integer keys.
+template <class Key, class Hash = std::hash<Key>>
+struct MixHash : private Hash
+{
+    MixHash() = default;
+
+    explicit MixHash(const Hash & hash)
+        : Hash(hash)
+    {
+    }
+
+    std::size_t operator()(const Key & key) const noexcept(noexcept(Hash::operator()(key)))
+    {
+        auto h = static_cast<std::uint64_t>(Hash::operator()(key));
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return static_cast<std::size_t>(h);
+    }
+};
@@ -0,0 +1,200 @@
+#pragma once
+
+#include "hash_functions.h"
+#include "hash_map.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+enum class JoinType
+{
+    Inner, // every matching (probe row, build row) pair
+    Semi,  // probe rows with at least one match
+    Anti   // probe rows without a match
+};
+
+// Output buffers of `HashJoin::probe`, appended to; an inner join fills both, `probe_rows[i]`
+// matching `build_rows[i]`, semi and anti joins fill `probe_rows` only
+struct JoinOutput
+{
+    std::vector<std::uint32_t> probe_rows;
+    std::vector<std::uint32_t> build_rows;
+
+    std::size_t size() const noexcept
+    {
+        return probe_rows.size();
+    }
+
+    void clear() noexcept
+    {
+        probe_rows.clear();
+        build_rows.clear();
+    }
+};
+
+// Build side of an equi-join: a `HashMap` from every distinct key to the first of its build rows,
+// the other rows with the same key chained through a per-row array, so duplicate keys cost 4 bytes
+// per row. Probing goes through batches of `BatchSize` keys, prefetching the home slots of the whole
+// batch before looking any of them up, and then the chains of the found keys before following them,
+// so that the cache misses of a batch overlap.
+// Rows are identified by their 32-bit index in the input batch.
+//
+//     HashJoin<std::uint64_t> join;
+//     join.build(orders.customer_id.data(), orders.size());
+//     JoinOutput out;
+//     join.probe(customers.id.data(), customers.size(), JoinType::Inner, out);
+template <class Key,
+          class Hash = std::hash<Key>,
+          class Equal = std::equal_to<Key>,
+          std::size_t BatchSize = 32>
+class HashJoin
+{
+    static_assert(BatchSize > 0, "batch should hold at least one key");
+
+public:
+    using key_type = Key;
+    using row_type = std::uint32_t;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+
+    static constexpr row_type npos = std::numeric_limits<row_type>::max();
+
+private:
+    HashMap<Key, row_type, LinearProbing, MixHash<Key, Hash>, Equal> m_heads;
+    std::vector<row_type> m_next; // next build row with the same key, or npos
+
+public:
+    explicit HashJoin(const hasher & hash = hasher(), const key_equal & equal = key_equal())
+        : m_heads(0, MixHash<Key, Hash>(hash), equal)
+    {
+    }
+
+    // number of build rows
+    size_type size() const noexcept
+    {
+        return m_next.size();
+    }
+
+    size_type distinct_keys() const noexcept
+    {
+        return m_heads.size();
+    }
+
+    // replaces the build side with a column of keys
+    void build(const Key * keys, const size_type count)
+    {
+        build_impl(count, [keys](const size_type i) -> const Key & { return keys[i]; });
+    }
+
+    // replaces the build side with rows, `key_of(row)` returns the join key of a row
+    template <class Row, class KeyOf>
+    void build(const Row * rows, const size_type count, KeyOf && key_of)
+    {
+        build_impl(count, [rows, &key_of](const size_type i) -> decltype(auto) { return key_of(rows[i]); });
+    }
+
+    // probes with a column of keys, appends the result to `out` and returns the number of appended rows
+    size_type probe(const Key * keys, const size_type count, const JoinType type, JoinOutput & out) const
+    {
+        return probe_impl(count, [keys](const size_type i) -> const Key & { return keys[i]; }, type, out);
+    }
+
+    // probes with rows, `key_of(row)` returns the join key of a row
+    template <class Row, class KeyOf>
+    size_type probe(const Row * rows, const size_type count, KeyOf && key_of, const JoinType type, JoinOutput & out) const
+    {
+        return probe_impl(count, [rows, &key_of](const size_type i) -> decltype(auto) { return key_of(rows[i]); }, type, out);
+    }
+
+    // calls `f(build_row)` for every build row with `key`, in build order
+    template <class F>
+    void for_each_match(const key_type & key, F && f) const
+    {
+        if (const auto it = m_heads.find(key); it != m_heads.end()) {
+            for (row_type row = it->second; row != npos; row = m_next[row]) {
+                f(row);
+            }
+        }
+    }
+
+private:
+    template <class KeyAt>
+    void build_impl(const size_type count, KeyAt && key_at)
+    {
+        if (count >= npos) {
+            throw std::length_error("HashJoin: too many build rows");
+        }
+        m_heads.clear();
+        m_heads.reserve(count);
+        m_next.assign(count, npos);
+        // backwards, so that chains list the rows of a key in build order
+        for (size_type end = count; end > 0;) {
+            const size_type begin = end > BatchSize ? end - BatchSize : 0;
+            for (size_type i = end; i-- > begin;) {
+                m_heads.prefetch(key_at(i));
+            }
+            for (size_type i = end; i-- > begin;) {
+                const auto row = static_cast<row_type>(i);
+                auto [it, inserted] = m_heads.try_emplace(key_at(i), row);
+                if (!inserted) {
+                    m_next[i] = it->second;
+                    it->second = row;
+                }
+            }
+            end = begin;
+        }
+    }
+
+    template <class KeyAt>
+    size_type probe_impl(const size_type count, KeyAt && key_at, const JoinType type, JoinOutput & out) const
+    {
+        if (count >= npos) {
+            throw std::length_error("HashJoin: too many probe rows");
+        }
+        const size_type appended = out.size();
+        row_type heads[BatchSize];
+        for (size_type begin = 0; begin < count; begin += BatchSize) {
+            const size_type end = std::min(count, begin + BatchSize);
+            for (size_type i = begin; i < end; ++i) {
+                m_heads.prefetch(key_at(i));
+            }
+            // chains are prefetched too, before any of them is followed
+            for (size_type i = begin; i < end; ++i) {
+                const auto it = m_heads.find(key_at(i));
+                heads[i - begin] = it != m_heads.end() ? it->second : npos;
+                if (type == JoinType::Inner && heads[i - begin] != npos) {
+                    __builtin_prefetch(&m_next[heads[i - begin]]);
+                }
+            }
+            for (size_type i = begin; i < end; ++i) {
+                const auto probe_row = static_cast<row_type>(i);
+                const row_type head = heads[i - begin];
+                switch (type) {
+                case JoinType::Inner:
+                    for (row_type row = head; row != npos; row = m_next[row]) {
+                        out.probe_rows.push_back(probe_row);
+                        out.build_rows.push_back(row);
+                    }
+                    break;
+                case JoinType::Semi:
+                    if (head != npos) {
+                        out.probe_rows.push_back(probe_row);
+                    }
+                    break;
+                case JoinType::Anti:
+                    if (head == npos) {
+                        out.probe_rows.push_back(probe_row);
+                    }
+                    break;
+                }
+            }
+        }
+        return out.size() - appended;
+    }
+};
@@ -1,10 +1,14 @@
 #pragma once
 
 #include "policy.h"
+#include "statistics.h"
+#include "table_details.h"
 
 #include <algorithm>
 #include <stdexcept>
 #include <tuple>
+#include <typeinfo>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -21,9 +25,17 @@ template <class Key,
           class Hash = std::hash<Key>,
           class Equal = std::equal_to<Key>,
           class RangeHash = MaskRangeHashing,
-          class RehashPolicy = Power2RehashPolicy>
+          class RehashPolicy = Power2RehashPolicy,
+          class AccessPolicy = NoAccessTracking,
+          class FilterPolicy = NoFilter,
+          class StatsPolicy = NoStats,
+          class SamplingPolicy = NoSampling>
 class HashMap : private Hash
     , private Equal
+    , private RehashPolicy
+    , private FilterPolicy
+    , private StatsPolicy
+    , private SamplingPolicy
 {
 public:
     using key_type = Key;
@@ -47,7 +59,7 @@ private:
     {
     };
 
-    struct Node
+    struct Node : AccessPolicy::Counter
     {
         value_type value;
         size_type next = m_end;
@@ -197,6 +209,13 @@ private:
     size_type m_begin;
     static constexpr size_type m_end = std::numeric_limits<size_type>::max();
 
+    size_type m_rehashes = 0;
+
+    // tombstones left by erasure
+    size_type m_erased = 0;
+
+    table_details::SharedRehashHook m_rehash_hook;
+
 public:
     using iterator = Iterator<false>;
     using const_iterator = Iterator<true>;
@@ -206,9 +225,12 @@ public:
                      const key_equal & equal = key_equal())
         : hasher(hash)
         , key_equal(equal)
+        , SamplingPolicy(typeid(HashMap))
         , m_data(RehashPolicy::new_size(RehashPolicy::buckets_number(expected_max_size)))
     {
+        StatsPolicy::on_allocate(m_data.size() * sizeof(Element));
         reset();
+        record_rebuild();
     }
 
     template <class InputIt>
@@ -225,10 +247,18 @@ public:
     HashMap(const HashMap & other)
         : hasher(other)
         , key_equal(other)
+        , RehashPolicy(other)
+        , FilterPolicy(other)
+        , StatsPolicy(other)
+        , SamplingPolicy(other)
         , m_data(other.m_data)
         , m_size(other.m_size)
         , m_begin(other.m_begin)
+        , m_rehashes(other.m_rehashes)
+        , m_erased(other.m_erased)
+        , m_rehash_hook(other.m_rehash_hook)
     {
+        record_rebuild();
     }
 
     HashMap(HashMap && other) = default;
@@ -305,7 +335,13 @@ public:
             ++it;
             m_data[cur].clear();
         }
+        if (m_erased != 0) {
+            for (Element & element : m_data) {
+                element.clear();
+            }
+        }
         reset();
+        record_rebuild();
     }
 
     std::pair<iterator, bool> insert(const value_type & value)
@@ -350,7 +386,7 @@ public:
 
     void insert(std::initializer_list<value_type> init)
     {
-        if (RehashPolicy::need_rehash(size() + init.size(), m_data.size())) {
+        if (too_loaded(size() + init.size())) {
             reserve(size() + init.size());
         }
         insert(init.begin(), init.end());
@@ -430,19 +466,24 @@ public:
 
     iterator erase(const_iterator first, const_iterator last)
     {
+        const size_type old_size = size();
         link_nodes(first.get_node().prev, last.m_pos);
         for (auto it = first; it != last;) {
             const size_type cur = it.m_pos;
             ++it;
             m_data[cur].erase();
             --m_size;
+            ++m_erased;
+        }
+        if (SamplingPolicy::sampled()) {
+            SamplingPolicy::on_erase(size(), old_size - size());
         }
         return create_iterator(last.m_pos);
     }
 
     size_type erase(const key_type & key)
     {
-        if (const size_type pos = search(key); m_data[pos].is_used()) {
+        if (const size_type pos = lookup(key); pos != m_end) {
             remove_node(pos);
             return 1;
         }
@@ -454,6 +495,13 @@ public:
         std::swap(m_data, other.m_data);
         std::swap(m_size, other.m_size);
         std::swap(m_begin, other.m_begin);
+        std::swap(m_rehashes, other.m_rehashes);
+        std::swap(m_erased, other.m_erased);
+        std::swap(static_cast<RehashPolicy &>(*this), static_cast<RehashPolicy &>(other));
+        std::swap(static_cast<SamplingPolicy &>(*this), static_cast<SamplingPolicy &>(other));
+        std::swap(m_rehash_hook, other.m_rehash_hook);
+        std::swap(static_cast<StatsPolicy &>(*this), static_cast<StatsPolicy &>(other));
+        std::swap(static_cast<FilterPolicy &>(*this), static_cast<FilterPolicy &>(other));
     }
 
     size_type count(const key_type & key) const
@@ -463,19 +511,24 @@ public:
 
     iterator find(const key_type & key)
     {
-        const size_type pos = search(key);
-        return create_iterator(m_data[pos].is_used() ? pos : m_end);
+        return create_iterator(lookup(key));
     }
 
     const_iterator find(const key_type & key) const
     {
-        const size_type pos = search(key);
-        return create_const_iterator(m_data[pos].is_used() ? pos : m_end);
+        return create_const_iterator(lookup(key));
     }
 
     bool contains(const key_type & key) const
     {
-        return m_data[search(key)].is_used();
+        return lookup(key) != m_end;
+    }
+
+    // hints the processor to load the home slot of `key`: batched lookups prefetch the keys of a batch
+    // before finding them, so that their cache misses overlap
+    void prefetch(const key_type & key) const
+    {
+        __builtin_prefetch(&m_data[index(key)]);
     }
 
     std::pair<iterator, iterator> equal_range(const key_type & key)
@@ -492,7 +545,7 @@ public:
 
     mapped_type & at(const key_type & key)
     {
-        if (const size_type pos = search(key); m_data[pos].is_used()) {
+        if (const size_type pos = lookup(key); pos != m_end) {
             return m_data[pos].get().value.second;
         }
         throw std::out_of_range("HashMap::at");
@@ -500,7 +553,7 @@ public:
 
     const mapped_type & at(const key_type & key) const
     {
-        if (const size_type pos = search(key); m_data[pos].is_used()) {
+        if (const size_type pos = lookup(key); pos != m_end) {
             return m_data[pos].get().value.second;
         }
         throw std::out_of_range("HashMap::at");
@@ -546,18 +599,58 @@ public:
         return RehashPolicy::max_load_factor();
     }
 
+    // for rehash policies with a per-table load factor, such as DynamicLoadFactorRehashPolicy
+    template <class Policy = RehashPolicy>
+    auto max_load_factor(const float ml) -> decltype(std::declval<Policy &>().max_load_factor(ml))
+    {
+        RehashPolicy::max_load_factor(ml);
+        if (too_loaded(size())) {
+            reserve(size());
+        }
+    }
+
     void rehash(const size_type count)
     {
-        HashMap old{std::move(*this)};
-        m_data = std::vector<Element>(RehashPolicy::new_size(count, old.m_data.size()));
+        const auto timer = StatsPolicy::start_timer();
+        const size_type new_bucket_count = RehashPolicy::new_size(count, bucket_count());
+        table_details::RehashNotification notification(m_rehash_hook, bucket_count(), new_bucket_count, size());
+        std::vector<Element> old(new_bucket_count);
+        StatsPolicy::on_allocate(old.size() * sizeof(Element));
+        std::swap(old, m_data);
+        const size_type last = table_details::last_linked(old, m_begin, m_end);
         reset();
-        for (auto & value : old) {
-            const size_type start = index(value.first);
-            size_type pos = start;
-            for (size_type step = 0; m_data[pos].is_used(); pos = CollisionPolicy::next(start, ++step, m_data.size())) {
-            }
-            insert_at(pos, std::move(value));
+        // insertion links elements in front, so going from the oldest one keeps the iteration order
+        for (size_type pos = last; pos != m_end; pos = old[pos].get().prev) {
+            auto & value = old[pos].get().value;
+            insert_at(free_pos(value.first), std::move(value));
+        }
+        ++m_rehashes;
+        record_rebuild();
+        StatsPolicy::on_rehash(timer);
+        notification.done();
+    }
+
+    // `hook` is called before and after every rehash, it must not modify the container
+    void set_rehash_hook(RehashHook hook)
+    {
+        m_rehash_hook = table_details::share_hook(std::move(hook));
+    }
+
+    // rebuilds the table placing the most frequently found elements first, so that they end up
+    // closest to their home slots; hit counters start over afterwards
+    void promote_hot()
+    {
+        static_assert(AccessPolicy::enabled, "promote_hot() requires access tracking");
+        const std::vector<size_type> order = table_details::by_hits(m_data, m_begin, m_end);
+        std::vector<Element> old(m_data.size());
+        StatsPolicy::on_allocate(old.size() * sizeof(Element));
+        std::swap(old, m_data);
+        reset();
+        for (const size_type pos : order) {
+            auto & value = old[pos].get().value;
+            insert_at(free_pos(value.first), std::move(value));
         }
+        record_rebuild();
     }
 
     void reserve(size_type count)
@@ -565,6 +658,50 @@ public:
         rehash(RehashPolicy::buckets_number(count));
     }
 
+    const StatsPolicy & instrumentation() const noexcept
+    {
+        return *this;
+    }
+
+    hasher hash_function() const
+    {
+        return *this;
+    }
+
+    key_equal key_eq() const
+    {
+        return *this;
+    }
+
+    MemoryUsage memory_usage() const
+    {
+        return memory_usage([](const value_type &) { return size_type{0}; });
+    }
+
+    // `owned_bytes(value)` should return the amount of heap memory owned by the value
+    template <class F>
+    MemoryUsage memory_usage(F && owned_bytes) const
+    {
+        MemoryUsage usage = table_details::memory_usage<value_type>(m_data, size(), owned_bytes);
+        usage.object_bytes = sizeof(*this);
+        usage.filter_bytes = FilterPolicy::filter_bytes();
+        return usage;
+    }
+
+    // slot-order scan of the whole table, takes O(bucket_count() * expected_miss_length) time
+    TableStats stats() const
+    {
+        TableStats stats = table_details::scan_stats(
+                m_data,
+                [this](const size_type pos) { return probe_length(pos); },
+                [this](const size_type pos) { return miss_length(pos); });
+        stats.size = size();
+        stats.bucket_count = bucket_count();
+        stats.rehashes = m_rehashes;
+        stats.load_factor = load_factor();
+        return stats;
+    }
+
     friend bool operator==(const HashMap & lhs, const HashMap & rhs)
     {
         if (lhs.size() != rhs.size()) {
@@ -590,9 +727,14 @@ private:
         return key_equal::operator()(a, b);
     }
 
+    constexpr size_type key_hash(const key_type & key) const noexcept
+    {
+        return hasher::operator()(key);
+    }
+
     constexpr size_type index(const key_type & key) const noexcept
     {
-        return RangeHash::hash(hasher::operator()(key), m_data.size());
+        return RangeHash::hash(key_hash(key), m_data.size());
     }
 
     constexpr iterator create_iterator(const size_type pos) noexcept
@@ -605,11 +747,15 @@ private:
         return {pos, m_data.data()};
     }
 
-    constexpr void remove_node(const size_type pos) noexcept
+    void remove_node(const size_type pos) noexcept
     {
         link_nodes(m_data[pos].get().prev, m_data[pos].get().next);
         m_data[pos].erase();
         --m_size;
+        ++m_erased;
+        if (SamplingPolicy::sampled()) {
+            SamplingPolicy::on_erase(size(), 1);
+        }
     }
 
     constexpr void link_nodes(const size_type left, const size_type right) noexcept
@@ -625,39 +771,91 @@ private:
         }
     }
 
-    constexpr size_type find_pos(const key_type & key, const bool seek_erased) const noexcept
+    constexpr size_type find_pos(const key_type & key, const size_type hash, const bool seek_erased) const noexcept
     {
-        const size_type start = index(key);
+        const size_type start = RangeHash::hash(hash, m_data.size());
         size_type first_erased = m_data.size();
+        StatsPolicy::on_lookup();
         for (size_type step = 0, i = start;; i = CollisionPolicy::next(start, ++step, m_data.size())) {
+            StatsPolicy::on_probe();
             if (m_data[i].is_empty()) {
                 return first_erased == m_data.size() ? i : first_erased;
             }
             if (m_data[i].is_used()) {
+                StatsPolicy::on_compare();
                 if (equal_keys(m_data[i].get().value.first, key)) {
                     return i;
                 }
             }
-            else if (seek_erased && first_erased == m_data.size()) {
-                first_erased = i;
+            else {
+                StatsPolicy::on_tombstone();
+                if (seek_erased && first_erased == m_data.size()) {
+                    first_erased = i;
+                }
             }
         }
     }
 
-    constexpr size_type search(const key_type & key) const noexcept
+    size_type lookup(const key_type & key) const noexcept
     {
-        return find_pos(key, false);
+        const size_type hash = key_hash(key);
+        if (!FilterPolicy::may_contain(hash)) {
+            return m_end;
+        }
+        const size_type pos = find_pos(key, hash, false);
+        if (!m_data[pos].is_used()) {
+            return m_end;
+        }
+        m_data[pos].get().hit();
+        return pos;
+    }
+
+    constexpr size_type free_pos(const key_type & key) const noexcept
+    {
+        const size_type start = index(key);
+        size_type pos = start;
+        for (size_type step = 0; m_data[pos].is_used(); pos = CollisionPolicy::next(start, ++step, m_data.size())) {
+        }
+        return pos;
+    }
+
+    // number of probes needed to find the element at `pos`
+    size_type probe_length(const size_type pos) const noexcept
+    {
+        const size_type start = index(m_data[pos].get().value.first);
+        size_type probes = 1;
+        for (size_type i = start; i != pos; i = CollisionPolicy::next(start, probes++, m_data.size())) {
+        }
+        return probes;
+    }
+
+    // number of probes needed to find an empty slot starting from `start`
+    size_type miss_length(const size_type start) const noexcept
+    {
+        size_type probes = 1;
+        for (size_type i = start; !m_data[i].is_empty() && probes <= m_data.size(); i = CollisionPolicy::next(start, probes++, m_data.size())) {
+        }
+        return probes;
     }
 
     constexpr size_type find_insertion_pos(const key_type & key) const noexcept
     {
-        return find_pos(key, true);
+        return find_pos(key, key_hash(key), true);
+    }
+
+    // tombstones lengthen probe sequences just like elements do, so they count towards the load;
+    // a rehash caused by them alone keeps the table size and only drops them
+    bool too_loaded(const size_type new_size) const
+    {
+        return RehashPolicy::need_rehash(new_size + m_erased, m_data.size());
     }
 
-    constexpr void reset() noexcept
+    void reset()
     {
         m_begin = m_end;
         m_size = 0;
+        m_erased = 0;
+        FilterPolicy::reset_filter(m_data.size());
     }
 
     template <class T, class M>
@@ -683,7 +881,7 @@ private:
     template <class... Args>
     std::pair<iterator, bool> common_emplace(key_type && key, Args &&... args)
     {
-        if (RehashPolicy::need_rehash(size() + 1, m_data.size())) {
+        if (too_loaded(size() + 1)) {
             reserve(size() + 1);
         }
         const size_type pos = find_insertion_pos(key);
@@ -716,7 +914,7 @@ private:
     template <class T, class... Args>
     size_type try_emplace_impl(T && key, Args &&... args)
     {
-        if (RehashPolicy::need_rehash(size() + 1, m_data.size())) {
+        if (too_loaded(size() + 1)) {
             reserve(size() + 1);
         }
         const size_type pos = find_insertion_pos(key);
@@ -738,13 +936,33 @@ private:
     template <class... Args>
     void insert_at(const size_type pos, Args &&... args)
     {
+        const bool reused_tombstone = !m_data[pos].is_empty();
+        if (reused_tombstone) {
+            --m_erased;
+        }
         m_data[pos].set(std::forward<Args>(args)...);
+        StatsPolicy::on_insert();
+        if constexpr (FilterPolicy::enabled) {
+            FilterPolicy::add_to_filter(key_hash(m_data[pos].get().value.first));
+        }
         m_data[pos].get().next = m_begin;
         if (m_begin != m_end) {
             m_data[m_begin].get().prev = pos;
         }
         m_begin = pos;
         ++m_size;
+        if (SamplingPolicy::sampled()) {
+            SamplingPolicy::on_insert(size(), probe_length(pos), reused_tombstone);
+        }
+    }
+
+    // sampled tables only: full scan to find the current longest probe
+    void record_rebuild() const noexcept
+    {
+        if (SamplingPolicy::sampled()) {
+            const size_type longest = table_details::max_probe_length(m_data, [this](const size_type pos) { return probe_length(pos); });
+            SamplingPolicy::on_rebuild(size(), bucket_count(), m_rehashes, longest, m_erased);
+        }
     }
 
     bool check_hint(const_iterator hint, const key_type & key)
@@ -0,0 +1,243 @@
+#pragma once
+
+#include "hash_set.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Measures how well a `Hash` functor spreads a sample of keys:
+//   - bias of every output bit,
+//   - avalanche: probability of every output bit to flip when a single input bit flips
+//     (only for trivially copyable keys, which are mutated bitwise),
+//   - chi-square of the bucket distribution under MaskRangeHashing at several table sizes,
+//   - probe lengths under every CollisionPolicy against the ones expected from an ideal hash,
+//   - time per hash.
+//
+//     const HashQualityReport report = analyze_hash<MyKey, MyHash>(sample);
+//     report.print(std::cout);
+//     return report.acceptable() ? 0 : 1;
+
+struct HashQualityReport
+{
+    struct Distribution
+    {
+        std::size_t bucket_count = 0;
+        double chi_square = 0;
+        double z_score = 0; // of chi-square against its expectation for an ideal hash, |z| > 3 is suspicious
+    };
+
+    struct Probing
+    {
+        std::string collision_policy;
+        double load_factor = 0;
+        double hit_probes = 0;
+        double expected_hit_probes = 0;
+        double miss_probes = 0;
+        double expected_miss_probes = 0;
+        std::size_t max_probe_length = 0;
+    };
+
+    std::size_t sample_size = 0;
+    double max_bit_bias = 0;       // max |P(bit = 1) - 0.5| over output bits
+    bool avalanche_measured = false;
+    double mean_flip_probability = 0; // 0.5 for an ideal hash
+    double max_avalanche_bias = 0;    // max |P(output bit flips) - 0.5| over input/output bit pairs
+    std::vector<Distribution> distributions;
+    std::vector<Probing> probing;
+    double ns_per_hash = 0;
+
+    // thresholds are loose enough for a sample of a few thousand keys to pass with a good hash
+    bool acceptable(const double max_bias = 0.05, const double max_avalanche = 0.2, const double max_z = 6, const double max_probe_ratio = 2) const
+    {
+        if (max_bit_bias > max_bias || (avalanche_measured && max_avalanche_bias > max_avalanche)) {
+            return false;
+        }
+        for (const Distribution & d : distributions) {
+            if (std::abs(d.z_score) > max_z) {
+                return false;
+            }
+        }
+        for (const Probing & p : probing) {
+            if (p.hit_probes > max_probe_ratio * p.expected_hit_probes || p.miss_probes > max_probe_ratio * p.expected_miss_probes) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void print(std::ostream & out) const
+    {
+        out << std::fixed << std::setprecision(4)
+            << "sample size:            " << sample_size << '\n'
+            << "time per hash:          " << std::setprecision(2) << ns_per_hash << " ns\n" << std::setprecision(4)
+            << "max output bit bias:    " << max_bit_bias << '\n';
+        if (avalanche_measured) {
+            out << "mean flip probability:  " << mean_flip_probability << '\n'
+                << "max avalanche bias:     " << max_avalanche_bias << '\n';
+        }
+        else {
+            out << "avalanche:              not measured, key is not trivially copyable\n";
+        }
+        out << "\nMaskRangeHashing bucket distribution\n"
+            << std::setw(12) << "buckets" << std::setw(16) << "chi-square" << std::setw(14) << "z" << '\n';
+        for (const Distribution & d : distributions) {
+            out << std::setw(12) << d.bucket_count << std::setprecision(1) << std::setw(16) << d.chi_square
+                << std::setprecision(2) << std::setw(14) << d.z_score << '\n';
+        }
+        out << "\nprobe lengths, observed / expected for an ideal hash\n"
+            << std::left << std::setw(18) << "collision" << std::right << std::setw(8) << "load"
+            << std::setw(18) << "hit" << std::setw(18) << "miss" << std::setw(8) << "max" << '\n';
+        for (const Probing & p : probing) {
+            out << std::left << std::setw(18) << p.collision_policy << std::right << std::setprecision(2)
+                << std::setw(8) << p.load_factor
+                << std::setw(10) << p.hit_probes << " / " << std::setw(5) << p.expected_hit_probes
+                << std::setw(10) << p.miss_probes << " / " << std::setw(5) << p.expected_miss_probes
+                << std::setw(8) << p.max_probe_length << '\n';
+        }
+        out << "\nverdict: " << (acceptable() ? "acceptable" : "poor") << '\n';
+    }
+};
+
+namespace hash_quality_details {
+
+inline double chi_square_z(const double chi_square, const std::size_t bucket_count)
+{
+    const double degrees = static_cast<double>(bucket_count - 1);
+    return (chi_square - degrees) / std::sqrt(2 * degrees);
+}
+
+inline HashQualityReport::Distribution distribution(const std::vector<std::uint64_t> & hashes, const std::size_t bucket_count)
+{
+    std::vector<std::size_t> counts(bucket_count);
+    for (const std::uint64_t h : hashes) {
+        ++counts[MaskRangeHashing::hash(static_cast<std::size_t>(h), bucket_count)];
+    }
+    const double expected = 1.0 * hashes.size() / bucket_count;
+    double chi_square = 0;
+    for (const std::size_t count : counts) {
+        chi_square += (count - expected) * (count - expected) / expected;
+    }
+    return {bucket_count, chi_square, chi_square_z(chi_square, bucket_count)};
+}
+
+template <class Key, class Hash, class CollisionPolicy>
+HashQualityReport::Probing probing(const std::vector<Key> & keys, const Hash & hash, const char * name)
+{
+    HashSet<Key, CollisionPolicy, Hash> set(0, hash);
+    for (const Key & key : keys) {
+        set.insert(key);
+    }
+    const TableStats stats = set.stats();
+    const double a = stats.load_factor;
+
+    HashQualityReport::Probing result;
+    result.collision_policy = name;
+    result.load_factor = a;
+    result.hit_probes = stats.average_probe_length;
+    result.miss_probes = stats.expected_miss_length;
+    result.max_probe_length = stats.max_probe_length();
+    if constexpr (std::is_same_v<CollisionPolicy, LinearProbing>) {
+        // Knuth
+        result.expected_hit_probes = 0.5 * (1 + 1 / (1 - a));
+        result.expected_miss_probes = 0.5 * (1 + 1 / ((1 - a) * (1 - a)));
+    }
+    else {
+        // uniform probing, a lower bound for quadratic probing which suffers from secondary clustering
+        result.expected_hit_probes = a > 0 ? std::log(1 / (1 - a)) / a : 1;
+        result.expected_miss_probes = 1 / (1 - a);
+    }
+    return result;
+}
+
+} // namespace hash_quality_details
+
+// `keys` are expected to be distinct
+template <class Key, class Hash = std::hash<Key>>
+HashQualityReport analyze_hash(const std::vector<Key> & keys, const Hash & hash = Hash())
+{
+    using namespace hash_quality_details;
+    constexpr std::size_t output_bits = 8 * sizeof(std::size_t);
+
+    HashQualityReport report;
+    report.sample_size = keys.size();
+    if (keys.empty()) {
+        return report;
+    }
+
+    std::vector<std::uint64_t> hashes;
+    hashes.reserve(keys.size());
+    for (const Key & key : keys) {
+        hashes.push_back(hash(key));
+    }
+
+    std::array<std::size_t, output_bits> ones{};
+    for (const std::uint64_t h : hashes) {
+        for (std::size_t bit = 0; bit < output_bits; ++bit) {
+            ones[bit] += (h >> bit) & 1;
+        }
+    }
+    for (const std::size_t count : ones) {
+        report.max_bit_bias = std::max(report.max_bit_bias, std::abs(1.0 * count / keys.size() - 0.5));
+    }
+
+    if constexpr (std::is_trivially_copyable_v<Key>) {
+        constexpr std::size_t input_bits = 8 * sizeof(Key);
+        std::vector<std::size_t> flips(input_bits * output_bits);
+        for (std::size_t k = 0; k < keys.size(); ++k) {
+            unsigned char bytes[sizeof(Key)];
+            std::memcpy(bytes, &keys[k], sizeof(Key));
+            for (std::size_t in = 0; in < input_bits; ++in) {
+                bytes[in / 8] ^= static_cast<unsigned char>(1u << (in % 8));
+                Key flipped;
+                std::memcpy(&flipped, bytes, sizeof(Key));
+                bytes[in / 8] ^= static_cast<unsigned char>(1u << (in % 8));
+                const std::uint64_t diff = hashes[k] ^ static_cast<std::uint64_t>(hash(flipped));
+                for (std::size_t out = 0; out < output_bits; ++out) {
+                    flips[in * output_bits + out] += (diff >> out) & 1;
+                }
+            }
+        }
+        double total = 0;
+        for (const std::size_t count : flips) {
+            const double p = 1.0 * count / keys.size();
+            total += p;
+            report.max_avalanche_bias = std::max(report.max_avalanche_bias, std::abs(p - 0.5));
+        }
+        report.avalanche_measured = true;
+        report.mean_flip_probability = total / flips.size();
+    }
+
+    // at least 8 keys per bucket on average, so that chi-square is meaningful
+    for (std::size_t bucket_count = 1 << 6; bucket_count <= (std::size_t{1} << 20) && bucket_count * 8 <= keys.size(); bucket_count <<= 2) {
+        report.distributions.push_back(distribution(hashes, bucket_count));
+    }
+
+    report.probing.push_back(probing<Key, Hash, LinearProbing>(keys, hash, "LinearProbing"));
+    report.probing.push_back(probing<Key, Hash, QuadraticProbing>(keys, hash, "QuadraticProbing"));
+
+    using Clock = std::chrono::steady_clock;
+    Clock::duration best = Clock::duration::max();
+    for (int repetition = 0; repetition < 5; ++repetition) {
+        std::uint64_t sum = 0;
+        const Clock::time_point start = Clock::now();
+        for (const Key & key : keys) {
+            sum += hash(key);
+        }
+        const Clock::time_point stop = Clock::now();
+        best = std::min(best, stop - start);
+        // keeps the loop from being optimized away
+        volatile std::uint64_t keep = sum;
+        static_cast<void>(keep);
+    }
+    report.ns_per_hash = 1e9 * std::chrono::duration<double>(best).count() / keys.size();
+    return report;
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include "hash_map.h"
+#include "hash_set.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Set of 32-bit integers split into blocks of 2^16 consecutive values (Roaring-style):
+// sparse blocks live in a common open addressing `HashSet`, a block holding at least
+// `DenseThreshold` keys is converted into a bitmap, so that a membership test for it is a single bit test.
+// A dense block goes back to the hash set once it drops below half of the threshold.
+template <class Key = std::uint32_t, std::size_t DenseThreshold = 1024>
+class HybridIntSet
+{
+    static_assert(std::is_integral_v<Key> && sizeof(Key) <= sizeof(std::uint32_t), "HybridIntSet supports 32-bit integer keys only");
+    static_assert(DenseThreshold > 1, "DenseThreshold should allow sparse blocks");
+
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using size_type = std::size_t;
+
+private:
+    static constexpr unsigned m_block_bits = 16;
+    static constexpr std::uint32_t m_block_mask = (1U << m_block_bits) - 1;
+    static constexpr size_type m_bitmap_words = (size_type{1} << m_block_bits) / 64;
+
+    using Bitmap = std::vector<std::uint64_t>;
+
+    HashSet<std::uint32_t> m_sparse;
+    HashMap<std::uint32_t, Bitmap> m_dense;
+    HashMap<std::uint32_t, size_type> m_block_sizes;
+
+    size_type m_size = 0;
+
+public:
+    explicit HybridIntSet(size_type expected_max_size = 0)
+        : m_sparse(expected_max_size)
+    {
+    }
+
+    template <class InputIt>
+    HybridIntSet(InputIt first, InputIt last, size_type expected_max_size = 0)
+        : HybridIntSet(expected_max_size)
+    {
+        insert(first, last);
+    }
+
+    HybridIntSet(std::initializer_list<value_type> init, size_type expected_max_size = 0)
+        : HybridIntSet(init.begin(), init.end(), expected_max_size)
+    {
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    // number of blocks stored as bitmaps
+    size_type dense_block_count() const
+    {
+        return m_dense.size();
+    }
+
+    void clear()
+    {
+        m_sparse.clear();
+        m_dense.clear();
+        m_block_sizes.clear();
+        m_size = 0;
+    }
+
+    bool insert(const value_type key)
+    {
+        const std::uint32_t value = static_cast<std::uint32_t>(key);
+        const std::uint32_t block = value >> m_block_bits;
+        if (const auto it = m_dense.find(block); it != m_dense.end()) {
+            std::uint64_t & word = it->second[(value & m_block_mask) / 64];
+            const std::uint64_t bit = 1ULL << (value % 64);
+            if (word & bit) {
+                return false;
+            }
+            word |= bit;
+            ++m_block_sizes[block];
+            ++m_size;
+            return true;
+        }
+        if (!m_sparse.insert(value).second) {
+            return false;
+        }
+        ++m_size;
+        if (++m_block_sizes[block] >= DenseThreshold) {
+            to_bitmap(block);
+        }
+        return true;
+    }
+
+    template <class InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        for (auto it = first; it != last; ++it) {
+            insert(*it);
+        }
+    }
+
+    size_type erase(const value_type key)
+    {
+        const std::uint32_t value = static_cast<std::uint32_t>(key);
+        const std::uint32_t block = value >> m_block_bits;
+        if (const auto it = m_dense.find(block); it != m_dense.end()) {
+            std::uint64_t & word = it->second[(value & m_block_mask) / 64];
+            const std::uint64_t bit = 1ULL << (value % 64);
+            if (!(word & bit)) {
+                return 0;
+            }
+            word &= ~bit;
+            --m_size;
+            if (--m_block_sizes.at(block) < DenseThreshold / 2) {
+                to_sparse(block);
+            }
+            return 1;
+        }
+        if (m_sparse.erase(value) == 0) {
+            return 0;
+        }
+        --m_size;
+        if (--m_block_sizes.at(block) == 0) {
+            m_block_sizes.erase(block);
+        }
+        return 1;
+    }
+
+    size_type count(const value_type key) const
+    {
+        return contains(key);
+    }
+
+    bool contains(const value_type key) const
+    {
+        const std::uint32_t value = static_cast<std::uint32_t>(key);
+        if (!m_dense.empty()) {
+            if (const auto it = m_dense.find(value >> m_block_bits); it != m_dense.end()) {
+                return (it->second[(value & m_block_mask) / 64] >> (value % 64)) & 1;
+            }
+        }
+        return m_sparse.contains(value);
+    }
+
+    // calls `f(key)` for every key of the set, in unspecified order
+    template <class F>
+    void for_each(F && f) const
+    {
+        for (const std::uint32_t value : m_sparse) {
+            f(static_cast<value_type>(value));
+        }
+        for (const auto & [block, bitmap] : m_dense) {
+            for (size_type i = 0; i < m_bitmap_words; ++i) {
+                for (std::uint64_t word = bitmap[i]; word != 0; word &= word - 1) {
+                    const auto low = static_cast<std::uint32_t>(i * 64 + __builtin_ctzll(word));
+                    f(static_cast<value_type>((block << m_block_bits) | low));
+                }
+            }
+        }
+    }
+
+    friend bool operator==(const HybridIntSet & lhs, const HybridIntSet & rhs)
+    {
+        if (lhs.size() != rhs.size()) {
+            return false;
+        }
+        bool equal = true;
+        lhs.for_each([&](const value_type key) {
+            equal = equal && rhs.contains(key);
+        });
+        return equal;
+    }
+
+    friend bool operator!=(const HybridIntSet & lhs, const HybridIntSet & rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+private:
+    void to_bitmap(const std::uint32_t block)
+    {
+        Bitmap bitmap(m_bitmap_words);
+        size_type left = m_block_sizes.at(block);
+        for (std::uint32_t low = 0; left != 0 && low <= m_block_mask; ++low) {
+            if (m_sparse.erase((block << m_block_bits) | low) != 0) {
+                bitmap[low / 64] |= 1ULL << (low % 64);
+                --left;
+            }
+        }
+        m_dense.try_emplace(block, std::move(bitmap));
+    }
+
+    void to_sparse(const std::uint32_t block)
+    {
+        const auto it = m_dense.find(block);
+        const Bitmap & bitmap = it->second;
+        for (size_type i = 0; i < m_bitmap_words; ++i) {
+            for (std::uint64_t word = bitmap[i]; word != 0; word &= word - 1) {
+                m_sparse.insert((block << m_block_bits) | static_cast<std::uint32_t>(i * 64 + __builtin_ctzll(word)));
+            }
+        }
+        m_dense.erase(it);
+        if (m_block_sizes.at(block) == 0) {
+            m_block_sizes.erase(block);
+        }
+    }
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// Thread fan-out shared by the bulk operations of `PartitionedHashMap` and `HashAggregator`
+namespace parallel_details {
+
+// calls `f(i)` for every `i` below `count`, from up to `threads` threads including the calling one;
+// the first exception thrown by `f` stops the remaining calls and is rethrown once all threads are done.
+// If a thread cannot be started, the ones already running share its part of the work.
+template <class F>
+void for_each(const std::size_t count, const unsigned threads, F && f)
+{
+    const std::size_t workers = std::min<std::size_t>(std::max(threads, 1u), count);
+    if (workers <= 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            f(i);
+        }
+        return;
+    }
+    std::atomic<std::size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    const auto work = [&] {
+        try {
+            for (std::size_t i; (i = next.fetch_add(1)) < count;) {
+                f(i);
+            }
+        }
+        catch (...) {
+            next = count;
+            const std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    try {
+        for (std::size_t i = 1; i < workers; ++i) {
+            pool.emplace_back(work);
+        }
+    }
+    catch (const std::system_error &) {
+    }
+    work();
+    for (std::thread & thread : pool) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace parallel_details
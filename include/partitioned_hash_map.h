@@ -0,0 +1,251 @@
+#pragma once
+
+#include "hash_functions.h"
+#include "hash_map.h"
+#include "parallel_details.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Two-level map for bulk builds and probes too large for the cache: keys are radix partitioned
+// by the top bits of their mixed hash into sub-tables sized to fit `cache_bytes` (a part of L2 by default),
+// and `build` / `probe` process the input partition by partition, so every sub-table stays
+// in cache while it is used. Partitions are independent, `threads` of them are processed at once.
+// The input rows are copied while partitioned, so bulk operations need default constructible keys
+// and values.
+//
+//     PartitionedHashMap<std::uint64_t, std::uint32_t> map;
+//     map.build(keys.data(), rows.data(), keys.size(), 8);
+//     std::vector<const std::uint32_t *> matches(probe_keys.size());
+//     map.probe(probe_keys.data(), probe_keys.size(), matches.data(), 8);
+template <class Key,
+          class Value,
+          class Hash = std::hash<Key>,
+          class Equal = std::equal_to<Key>>
+class PartitionedHashMap : private MixHash<Key, Hash>
+    , private Equal
+{
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+
+private:
+    using PartitionHash = MixHash<Key, Hash>;
+    using Table = HashMap<Key, Value, LinearProbing, PartitionHash, Equal>;
+
+    size_type m_cache_bytes;
+    unsigned m_partition_bits = 0;
+    std::vector<Table> m_partitions;
+    size_type m_size = 0;
+
+public:
+    explicit PartitionedHashMap(const size_type cache_bytes = 1024 * 1024,
+                                const hasher & hash = hasher(),
+                                const key_equal & equal = key_equal())
+        : PartitionHash(hash)
+        , key_equal(equal)
+        , m_cache_bytes(std::max<size_type>(cache_bytes, 1))
+    {
+        clear();
+    }
+
+    bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    size_type size() const noexcept
+    {
+        return m_size;
+    }
+
+    size_type partition_count() const noexcept
+    {
+        return m_partitions.size();
+    }
+
+    void clear()
+    {
+        m_partition_bits = 0;
+        m_partitions.assign(1, make_table(0));
+        m_size = 0;
+    }
+
+    // replaces the contents with `count` rows, `keys[i]` mapped to `values[i]`;
+    // of duplicate keys the first one is kept; if it throws, the map is left unchanged
+    void build(const Key * keys, const Value * values, const size_type count, const unsigned threads = 1)
+    {
+        const unsigned bits = partition_bits(count);
+        std::vector<std::pair<Key, Value>> rows;
+        const std::vector<size_type> bounds = partition(keys, count, bits, rows, [keys, values](const size_type i) {
+            return std::pair<Key, Value>(keys[i], values[i]);
+        });
+
+        std::vector<Table> partitions(bounds.size() - 1);
+        parallel_details::for_each(partitions.size(), threads, [&](const size_type p) {
+            Table table = make_table(bounds[p + 1] - bounds[p]);
+            for (size_type i = bounds[p]; i < bounds[p + 1]; ++i) {
+                table.try_emplace(std::move(rows[i].first), std::move(rows[i].second));
+            }
+            partitions[p] = std::move(table);
+        });
+        size_type size = 0;
+        for (const Table & table : partitions) {
+            size += table.size();
+        }
+        m_partition_bits = bits;
+        m_partitions = std::move(partitions);
+        m_size = size;
+    }
+
+    // `results[i]` points to the value of `keys[i]`, or is nullptr if there is none
+    void probe(const Key * keys, const size_type count, const Value ** results, const unsigned threads = 1) const
+    {
+        std::fill(results, results + count, nullptr);
+        probe(keys, count, [results](const size_type row, const Value & value) { results[row] = &value; }, threads);
+    }
+
+    // calls `on_match(i, value)` for every `keys[i]` present in the map, grouped by partition rather
+    // than in row order, which saves the random writes of a result array;
+    // with several threads `on_match` is called concurrently for different partitions
+    template <class F>
+    void probe(const Key * keys, const size_type count, F && on_match, const unsigned threads = 1) const
+    {
+        std::vector<std::pair<Key, size_type>> rows;
+        const std::vector<size_type> bounds = partition(keys, count, m_partition_bits, rows, [keys](const size_type i) {
+            return std::pair<Key, size_type>(keys[i], i);
+        });
+        parallel_details::for_each(m_partitions.size(), threads, [&](const size_type p) {
+            const Table & table = m_partitions[p];
+            for (size_type i = bounds[p]; i < bounds[p + 1]; ++i) {
+                const auto it = table.find(rows[i].first);
+                if (it != table.end()) {
+                    on_match(rows[i].second, it->second);
+                }
+            }
+        });
+    }
+
+    const Value * find(const key_type & key) const
+    {
+        const Table & table = m_partitions[partition_of(hash(key))];
+        const auto it = table.find(key);
+        return it != table.end() ? &it->second : nullptr;
+    }
+
+    Value * find(const key_type & key)
+    {
+        return const_cast<Value *>(std::as_const(*this).find(key));
+    }
+
+    bool contains(const key_type & key) const
+    {
+        return find(key) != nullptr;
+    }
+
+    Value & at(const key_type & key)
+    {
+        if (Value * value = find(key)) {
+            return *value;
+        }
+        throw std::out_of_range("PartitionedHashMap::at");
+    }
+
+    const Value & at(const key_type & key) const
+    {
+        if (const Value * value = find(key)) {
+            return *value;
+        }
+        throw std::out_of_range("PartitionedHashMap::at");
+    }
+
+    // single row insertion, the partitioning chosen by the last `build` is kept
+    template <class... Args>
+    std::pair<Value *, bool> try_emplace(const key_type & key, Args &&... args)
+    {
+        auto [it, inserted] = m_partitions[partition_of(hash(key))].try_emplace(key, std::forward<Args>(args)...);
+        m_size += inserted ? 1 : 0;
+        return {&it->second, inserted};
+    }
+
+    // `f(const Key &, Value &)`
+    template <class F>
+    void for_each(F && f)
+    {
+        for (Table & table : m_partitions) {
+            for (auto & entry : table) {
+                f(static_cast<const Key &>(entry.first), entry.second);
+            }
+        }
+    }
+
+    // `f(const Key &, const Value &)`
+    template <class F>
+    void for_each(F && f) const
+    {
+        const_cast<PartitionedHashMap &>(*this).for_each([&f](const Key & key, const Value & value) { f(key, value); });
+    }
+
+private:
+    std::uint64_t hash(const key_type & key) const
+    {
+        return PartitionHash::operator()(key);
+    }
+
+    size_type partition_of(const std::uint64_t h) const noexcept
+    {
+        return partition_of(h, m_partition_bits);
+    }
+
+    static size_type partition_of(const std::uint64_t h, const unsigned bits) noexcept
+    {
+        return bits == 0 ? 0 : static_cast<size_type>(h >> (64 - bits));
+    }
+
+    Table make_table(const size_type expected_size) const
+    {
+        return Table(expected_size, *this, *this);
+    }
+
+    // smallest power of 2 number of partitions with every sub-table fitting the cache; the fan-out is
+    // capped because scattering into too many partitions at once thrashes the TLB and the write buffers
+    unsigned partition_bits(const size_type count) const
+    {
+        const Table sample = make_table(0);
+        const double table_bytes = count * static_cast<double>(sample.memory_usage().slot_bytes) / sample.max_load_factor();
+        unsigned bits = 0;
+        while (bits < 12 && table_bytes / static_cast<double>(size_type{1} << bits) > static_cast<double>(m_cache_bytes)) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    // radix partitioning into `2^bits` partitions: copies `row(i)` of every input key into `rows`, grouped
+    // by partition, so that every partition is then read sequentially; returns the partition boundaries in `rows`
+    template <class Row, class F>
+    std::vector<size_type> partition(const Key * keys, const size_type count, const unsigned bits, std::vector<Row> & rows, F && row) const
+    {
+        std::vector<std::uint32_t> partition(count);
+        std::vector<size_type> bounds((size_type{1} << bits) + 1);
+        for (size_type i = 0; i < count; ++i) {
+            partition[i] = static_cast<std::uint32_t>(partition_of(hash(keys[i]), bits));
+            ++bounds[partition[i] + 1];
+        }
+        for (size_type p = 1; p < bounds.size(); ++p) {
+            bounds[p] += bounds[p - 1];
+        }
+        std::vector<size_type> next(bounds.begin(), bounds.end() - 1);
+        rows.resize(count);
+        for (size_type i = 0; i < count; ++i) {
+            rows[next[partition[i]]++] = row(i);
+        }
+        return bounds;
+    }
+};
@@ -1,13 +1,21 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <limits>
+#include <stdexcept>
+#include <typeinfo>
 
 struct LinearProbing
 {
     static constexpr std::size_t next(const std::size_t start, const std::size_t step, const std::size_t size) noexcept
     {
-        return (start + step) & (size - 1);
+        if ((size & (size - 1)) == 0) {
+            return (start + step) & (size - 1);
+        }
+        const std::size_t pos = start + step;
+        return pos < size ? pos : pos % size;
     }
 };
 
@@ -18,7 +26,11 @@ struct QuadraticProbing
         if ((size & (size - 1)) == 0) { // Is size is power of 2, then we can choose coefficients that will avoid ending up in cycle
             return (start + ((step * step + step) >> 1)) & (size - 1);
         }
-        return (start + step * step) % size;
+        if (step < size) {
+            return (start + step * step) % size;
+        }
+        // squares do not cover every slot of an arbitrary sized table, so continue linearly to be sure to find a free one
+        return (start + step) % size;
     }
 };
 
@@ -30,6 +42,33 @@ struct MaskRangeHashing
     }
 };
 
+// Multiplicative (Fibonacci) hashing: takes the top bits of the hash multiplied by 2^64 / phi,
+// so keys differing only in their high bits (strided ints, aligned pointers) still spread over the table.
+// Requires power of 2 table size.
+struct FibonacciRangeHashing
+{
+    static constexpr std::size_t hash(const std::size_t index, const std::size_t size) noexcept
+    {
+        if (size <= 1) {
+            return 0;
+        }
+        return static_cast<std::size_t>((static_cast<unsigned long long>(index) * 0x9e3779b97f4a7c15ULL) >> (64 - __builtin_ctzll(size)));
+    }
+};
+
+// Maps the hash to [0, size) with a multiply-high instead of a division (Lemire's fastrange), so it
+// supports any table size. The hash is scrambled by the Fibonacci multiplier first, otherwise small
+// hashes (identity std::hash of small ints) would all map to the first slots.
+struct FastRangeHashing
+{
+    static constexpr std::size_t hash(const std::size_t index, const std::size_t size) noexcept
+    {
+        __extension__ using uint128 = unsigned __int128;
+        const unsigned long long mixed = static_cast<unsigned long long>(index) * 0x9e3779b97f4a7c15ULL;
+        return static_cast<std::size_t>((static_cast<uint128>(mixed) * size) >> 64);
+    }
+};
+
 struct Power2RehashPolicy
 {
     static constexpr float max_load_factor() noexcept
@@ -55,3 +94,168 @@ struct Power2RehashPolicy
         return current_size;
     }
 };
+
+// Power of 2 table sizes kept at most MaxLoadPercent percent full
+template <unsigned MaxLoadPercent>
+struct LoadFactorRehashPolicy
+{
+    static_assert(MaxLoadPercent > 0 && MaxLoadPercent < 100, "an open addressing table needs free slots");
+
+    static constexpr float max_load_factor() noexcept
+    {
+        return MaxLoadPercent / 100.0f;
+    }
+
+    static constexpr bool need_rehash(const std::size_t size, const std::size_t bucket_count) noexcept
+    {
+        return size * 100 > bucket_count * MaxLoadPercent;
+    }
+
+    static constexpr std::size_t buckets_number(const std::size_t desired_size) noexcept
+    {
+        return (desired_size * 100 + MaxLoadPercent - 1) / MaxLoadPercent;
+    }
+
+    static constexpr std::size_t new_size(const std::size_t desired_size, std::size_t current_size = 64) noexcept
+    {
+        return Power2RehashPolicy::new_size(desired_size, current_size);
+    }
+};
+
+// Doubles tables up to LargeTableSize buckets and grows larger ones by 1.5x, so that growing a
+// multi-GB table needs 2.5x of its memory at the peak of the rehash instead of 3x, and leaves less
+// of it unused afterwards. Sizes past the threshold are not powers of 2, use FastRangeHashing.
+template <std::size_t LargeTableSize = (std::size_t{1} << 26), unsigned MaxLoadPercent = 50>
+struct GradualGrowthRehashPolicy : LoadFactorRehashPolicy<MaxLoadPercent>
+{
+    static constexpr std::size_t new_size(const std::size_t desired_size, std::size_t current_size = 64) noexcept
+    {
+        while (current_size < desired_size && current_size < LargeTableSize) {
+            current_size <<= 1;
+        }
+        if (current_size < desired_size) {
+            // exactly the desired size on reserve()
+            current_size = std::max(desired_size, current_size + (current_size >> 1));
+        }
+        return current_size;
+    }
+};
+
+// Power of 2 table sizes with the maximal load factor set per table at runtime through
+// `max_load_factor(float)` of the container, 0.5 by default.
+// Loads of 0.75-0.9 save up to 40% of memory; QuadraticProbing with a well mixed hash (or
+// FibonacciRangeHashing) stays fast there, while LinearProbing clusters quickly above 0.7.
+class DynamicLoadFactorRehashPolicy
+{
+public:
+    float max_load_factor() const noexcept
+    {
+        return m_max_load_factor;
+    }
+
+    void max_load_factor(const float ml)
+    {
+        if (!(ml > 0 && ml < 1)) {
+            throw std::invalid_argument("max_load_factor should be in (0, 1) for open addressing");
+        }
+        m_max_load_factor = ml;
+    }
+
+    bool need_rehash(const std::size_t size, const std::size_t bucket_count) const noexcept
+    {
+        return static_cast<double>(size) > static_cast<double>(bucket_count) * m_max_load_factor;
+    }
+
+    std::size_t buckets_number(const std::size_t desired_size) const noexcept
+    {
+        return static_cast<std::size_t>(std::ceil(desired_size / static_cast<double>(m_max_load_factor)));
+    }
+
+    static constexpr std::size_t new_size(const std::size_t desired_size, std::size_t current_size = 64) noexcept
+    {
+        return Power2RehashPolicy::new_size(desired_size, current_size);
+    }
+
+private:
+    float m_max_load_factor = 0.5f;
+};
+
+struct NoAccessTracking
+{
+    static constexpr bool enabled = false;
+
+    struct Counter
+    {
+        constexpr void hit() const noexcept {}
+
+        constexpr std::size_t hits() const noexcept
+        {
+            return 0;
+        }
+    };
+};
+
+// Counts successful lookups per element, so that `promote_hot()` can move frequently accessed
+// keys closer to their home slot. Const `find` / `contains` / `count` write the counters, so tables
+// with access tracking are not safe for concurrent lookups, const ones included.
+struct AccessTracking
+{
+    static constexpr bool enabled = true;
+
+    struct Counter
+    {
+        void hit() const noexcept
+        {
+            ++m_hits;
+        }
+
+        std::size_t hits() const noexcept
+        {
+            return m_hits;
+        }
+
+    private:
+        mutable std::size_t m_hits = 0;
+    };
+};
+
+struct NoFilter
+{
+    static constexpr bool enabled = false;
+
+    constexpr void reset_filter(std::size_t) noexcept {}
+
+    constexpr void add_to_filter(std::size_t) noexcept {}
+
+    constexpr bool may_contain(std::size_t) const noexcept
+    {
+        return true;
+    }
+
+    constexpr std::size_t filter_bytes() const noexcept
+    {
+        return 0;
+    }
+};
+
+// `SamplingPolicy` of tables not reporting to the process-wide registry, see `RegistrySampling`
+// in table_registry.h
+struct NoSampling
+{
+    static constexpr bool enabled = false;
+
+    NoSampling() = default;
+
+    constexpr explicit NoSampling(const std::type_info &) noexcept {}
+
+    constexpr bool sampled() const noexcept
+    {
+        return false;
+    }
+
+    constexpr void on_insert(std::size_t, std::size_t, bool) const noexcept {}
+
+    constexpr void on_erase(std::size_t, std::size_t) const noexcept {}
+
+    constexpr void on_rebuild(std::size_t, std::size_t, std::size_t, std::size_t, std::size_t) const noexcept {}
+};
@@ -0,0 +1,278 @@
+#pragma once
+
+#include "hash_functions.h"
+#include "hash_map.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Extendible hashing over fixed capacity `HashMap` segments:
+// the directory maps the top `global_depth()` bits of the mixed hash to a segment, several
+// directory entries share a segment whose local depth is smaller. A full segment is split in two
+// by the next hash bit, which moves only its own entries, and the directory is doubled (copying
+// segment indices only) when the splitting segment is as deep as the directory.
+// So growth costs O(SegmentCapacity) per split and no allocation is ever table-sized.
+// Segments are not merged back on erasure.
+// Entries are visited with `for_each`, pointers to values stay valid until the next insertion.
+template <class Key,
+          class Value,
+          class Hash = std::hash<Key>,
+          class Equal = std::equal_to<Key>,
+          std::size_t SegmentCapacity = 4096>
+class SegmentedHashMap : private MixHash<Key, Hash>
+    , private Equal
+{
+    static_assert(SegmentCapacity > 0, "segment should hold at least one entry");
+
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+
+private:
+    using SegmentHash = MixHash<Key, Hash>;
+    using Table = HashMap<Key, Value, LinearProbing, SegmentHash, Equal>;
+
+    struct Segment
+    {
+        Table table;
+        unsigned depth;
+        // entries after which a split is tried, grows when all entries share the next hash bit
+        size_type capacity;
+    };
+
+    std::vector<std::unique_ptr<Segment>> m_segments;
+    std::vector<std::uint32_t> m_directory; // segment index by top hash bits
+    unsigned m_global_depth = 0;
+    size_type m_size = 0;
+
+public:
+    explicit SegmentedHashMap(const hasher & hash = hasher(), const key_equal & equal = key_equal())
+        : SegmentHash(hash)
+        , key_equal(equal)
+    {
+        clear();
+    }
+
+    SegmentedHashMap(const SegmentedHashMap & other)
+        : SegmentHash(other)
+        , key_equal(other)
+        , m_directory(other.m_directory)
+        , m_global_depth(other.m_global_depth)
+        , m_size(other.m_size)
+    {
+        m_segments.reserve(other.m_segments.size());
+        for (const auto & segment : other.m_segments) {
+            m_segments.push_back(std::make_unique<Segment>(*segment));
+        }
+    }
+
+    SegmentedHashMap(SegmentedHashMap && other) = default;
+
+    SegmentedHashMap & operator=(const SegmentedHashMap & other)
+    {
+        return *this = SegmentedHashMap{other};
+    }
+
+    SegmentedHashMap & operator=(SegmentedHashMap && other) noexcept = default;
+
+    bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    size_type size() const noexcept
+    {
+        return m_size;
+    }
+
+    size_type segment_count() const noexcept
+    {
+        return m_segments.size();
+    }
+
+    unsigned global_depth() const noexcept
+    {
+        return m_global_depth;
+    }
+
+    void clear()
+    {
+        m_segments.clear();
+        m_segments.push_back(make_segment(0, SegmentCapacity));
+        m_directory.assign(1, 0);
+        m_global_depth = 0;
+        m_size = 0;
+    }
+
+    Value * find(const key_type & key)
+    {
+        return const_cast<Value *>(std::as_const(*this).find(key));
+    }
+
+    const Value * find(const key_type & key) const
+    {
+        const Table & table = segment(hash(key)).table;
+        const auto it = table.find(key);
+        return it != table.end() ? &it->second : nullptr;
+    }
+
+    bool contains(const key_type & key) const
+    {
+        return find(key) != nullptr;
+    }
+
+    size_type count(const key_type & key) const
+    {
+        return contains(key) ? 1 : 0;
+    }
+
+    Value & at(const key_type & key)
+    {
+        if (Value * value = find(key)) {
+            return *value;
+        }
+        throw std::out_of_range("SegmentedHashMap::at");
+    }
+
+    const Value & at(const key_type & key) const
+    {
+        if (const Value * value = find(key)) {
+            return *value;
+        }
+        throw std::out_of_range("SegmentedHashMap::at");
+    }
+
+    template <class... Args>
+    std::pair<Value *, bool> try_emplace(const key_type & key, Args &&... args)
+    {
+        const std::uint64_t h = hash(key);
+        Segment * target = &segment(h);
+        if (target->table.size() >= target->capacity) {
+            const auto it = target->table.find(key);
+            if (it != target->table.end()) {
+                return {&it->second, false};
+            }
+            split(h);
+            target = &segment(h);
+        }
+        auto [it, inserted] = target->table.try_emplace(key, std::forward<Args>(args)...);
+        m_size += inserted;
+        return {&it->second, inserted};
+    }
+
+    template <class M>
+    std::pair<Value *, bool> insert_or_assign(const key_type & key, M && value)
+    {
+        auto result = try_emplace(key, std::forward<M>(value));
+        if (!result.second) {
+            *result.first = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    Value & operator[](const key_type & key)
+    {
+        return *try_emplace(key).first;
+    }
+
+    size_type erase(const key_type & key)
+    {
+        const size_type erased = segment(hash(key)).table.erase(key);
+        m_size -= erased;
+        return erased;
+    }
+
+    // `f(const Key &, Value &)`
+    template <class F>
+    void for_each(F && f)
+    {
+        for (auto & segment : m_segments) {
+            for (auto & entry : segment->table) {
+                f(static_cast<const Key &>(entry.first), entry.second);
+            }
+        }
+    }
+
+    // `f(const Key &, const Value &)`
+    template <class F>
+    void for_each(F && f) const
+    {
+        const_cast<SegmentedHashMap &>(*this).for_each([&f](const Key & key, const Value & value) { f(key, value); });
+    }
+
+private:
+    std::uint64_t hash(const key_type & key) const
+    {
+        return SegmentHash::operator()(key);
+    }
+
+    size_type directory_index(const std::uint64_t h) const noexcept
+    {
+        return m_global_depth == 0 ? 0 : static_cast<size_type>(h >> (64 - m_global_depth));
+    }
+
+    Segment & segment(const std::uint64_t h) const
+    {
+        return *m_segments[m_directory[directory_index(h)]];
+    }
+
+    std::unique_ptr<Segment> make_segment(const unsigned depth, const size_type capacity) const
+    {
+        return std::make_unique<Segment>(Segment{Table(capacity, *this, *this), depth, capacity});
+    }
+
+    // splits the segment holding hash `h` by the hash bit following its local depth
+    void split(const std::uint64_t h)
+    {
+        const size_type index = m_directory[directory_index(h)];
+        Segment & old = *m_segments[index];
+        const unsigned depth = old.depth;
+        const auto upper_half = [this, depth](const key_type & key) {
+            return (hash(key) >> (63 - depth)) & 1;
+        };
+
+        size_type upper = 0;
+        for (const auto & entry : old.table) {
+            upper += upper_half(entry.first);
+        }
+        if (depth == 63 || upper == 0 || upper == old.table.size()) {
+            // the hashes do not differ in that bit, splitting would leave one side full
+            old.capacity *= 2;
+            return;
+        }
+
+        if (depth == m_global_depth) {
+            std::vector<std::uint32_t> directory(m_directory.size() * 2);
+            for (size_type i = 0; i < directory.size(); ++i) {
+                directory[i] = m_directory[i >> 1];
+            }
+            m_directory.swap(directory);
+            ++m_global_depth;
+        }
+
+        auto lower_segment = make_segment(depth + 1, SegmentCapacity);
+        auto upper_segment = make_segment(depth + 1, SegmentCapacity);
+        for (auto & entry : old.table) {
+            Table & table = upper_half(entry.first) ? upper_segment->table : lower_segment->table;
+            table.try_emplace(entry.first, std::move(entry.second));
+        }
+
+        // directory entries of the old segment form a range, its upper half goes to the new segment
+        const unsigned shift = m_global_depth - depth;
+        const size_type first = (directory_index(h) >> shift) << shift;
+        const size_type count = size_type{1} << shift;
+        const auto upper_index = static_cast<std::uint32_t>(m_segments.size());
+        for (size_type i = first + count / 2; i < first + count; ++i) {
+            m_directory[i] = upper_index;
+        }
+        m_segments[index] = std::move(lower_segment);
+        m_segments.push_back(std::move(upper_segment));
+    }
+};
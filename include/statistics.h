@@ -0,0 +1,181 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Memory held by a `HashMap` / `HashSet`, as reported by `memory_usage()`
+struct MemoryUsage
+{
+    std::size_t object_bytes = 0; // the container object itself
+    std::size_t table_bytes = 0;  // slot array, including empty and erased slots
+    std::size_t filter_bytes = 0; // lookup prefilter, if any
+    std::size_t slot_bytes = 0;   // size of a single slot
+
+    // breakdown of `table_bytes`
+    std::size_t payload_bytes = 0; // stored values
+    std::size_t link_bytes = 0;    // iteration order links of used slots
+    std::size_t padding_bytes = 0; // slot state tag, alignment and access counters of used slots
+    std::size_t empty_bytes = 0;   // never used slots
+    std::size_t erased_bytes = 0;  // tombstones
+
+    // heap memory owned by keys and values, as reported by the user supplied function
+    std::size_t owned_bytes = 0;
+
+    std::size_t total_bytes() const noexcept
+    {
+        return object_bytes + table_bytes + filter_bytes + owned_bytes;
+    }
+};
+
+// Probe length and occupancy statistics of a `HashMap` / `HashSet`, as reported by `stats()`
+struct TableStats
+{
+    std::size_t size = 0;
+    std::size_t bucket_count = 0;
+    std::size_t tombstones = 0;
+    std::size_t rehashes = 0; // number of rehashes since construction
+    float load_factor = 0;
+
+    // probe_lengths[i] is the number of present keys found with i + 1 probes
+    std::vector<std::size_t> probe_lengths;
+    double average_probe_length = 0;
+    // average number of probes of an unsuccessful lookup, over all home slots
+    double expected_miss_length = 0;
+    // longest run of consecutive non-empty (used or erased) slots
+    std::size_t longest_cluster = 0;
+
+    std::size_t max_probe_length() const noexcept
+    {
+        return probe_lengths.size();
+    }
+};
+
+// Passed to the rehash hook of `HashMap` / `HashSet` before and after every rehash
+struct RehashEvent
+{
+    enum class Phase
+    {
+        Before,
+        After
+    };
+
+    Phase phase = Phase::Before;
+    std::size_t old_bucket_count = 0;
+    std::size_t new_bucket_count = 0;
+    std::size_t size = 0;
+    std::chrono::nanoseconds duration{0}; // set for `Phase::After` only
+};
+
+using RehashHook = std::function<void(const RehashEvent &)>;
+
+// `StatsPolicy` of `HashMap` / `HashSet` which records nothing and costs nothing
+struct NoStats
+{
+    static constexpr bool enabled = false;
+
+    struct Timer
+    {
+    };
+
+    constexpr void on_lookup() const noexcept {}
+
+    constexpr void on_probe() const noexcept {}
+
+    constexpr void on_compare() const noexcept {}
+
+    constexpr void on_tombstone() const noexcept {}
+
+    constexpr void on_insert() const noexcept {}
+
+    constexpr void on_allocate(std::size_t) const noexcept {}
+
+    constexpr Timer start_timer() const noexcept
+    {
+        return {};
+    }
+
+    constexpr void on_rehash(Timer) const noexcept {}
+};
+
+// `StatsPolicy` of `HashMap` / `HashSet` counting hot path events,
+// counters are accessible through `instrumentation().counters()`
+class CountingStats
+{
+public:
+    static constexpr bool enabled = true;
+
+    using Timer = std::chrono::steady_clock::time_point;
+
+    struct Counters
+    {
+        std::size_t lookups = 0;
+        std::size_t probes = 0;
+        std::size_t compares = 0;
+        std::size_t tombstones_skipped = 0;
+        std::size_t inserts = 0; // elements placed into slots, including ones moved by rehash
+        std::size_t rehashes = 0;
+        std::chrono::nanoseconds rehash_time{0};
+        std::size_t allocated_bytes = 0;
+
+        double probes_per_lookup() const noexcept
+        {
+            return lookups != 0 ? 1.0 * probes / lookups : 0;
+        }
+    };
+
+    const Counters & counters() const noexcept
+    {
+        return m_counters;
+    }
+
+    void reset_counters() noexcept
+    {
+        m_counters = Counters{};
+    }
+
+    void on_lookup() const noexcept
+    {
+        ++m_counters.lookups;
+    }
+
+    void on_probe() const noexcept
+    {
+        ++m_counters.probes;
+    }
+
+    void on_compare() const noexcept
+    {
+        ++m_counters.compares;
+    }
+
+    void on_tombstone() const noexcept
+    {
+        ++m_counters.tombstones_skipped;
+    }
+
+    void on_insert() const noexcept
+    {
+        ++m_counters.inserts;
+    }
+
+    void on_allocate(const std::size_t bytes) const noexcept
+    {
+        m_counters.allocated_bytes += bytes;
+    }
+
+    Timer start_timer() const noexcept
+    {
+        return std::chrono::steady_clock::now();
+    }
+
+    void on_rehash(const Timer start) const noexcept
+    {
+        ++m_counters.rehashes;
+        m_counters.rehash_time += std::chrono::steady_clock::now() - start;
+    }
+
+private:
+    mutable Counters m_counters;
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "statistics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Implementation shared by `HashMap` and `HashSet`: `Element` is their slot type, with
+// `is_used()`, `is_empty()` and `get().value`
+namespace table_details {
+
+// `owned_bytes(value)` should return the amount of heap memory owned by the value;
+// the object and filter sizes are left for the container to fill in
+template <class Value, class Element, class F>
+MemoryUsage memory_usage(const std::vector<Element> & slots, const std::size_t size, F && owned_bytes)
+{
+    MemoryUsage usage;
+    usage.slot_bytes = sizeof(Element);
+    // the slot count rather than the vector capacity, so that the breakdown adds up to it
+    usage.table_bytes = slots.size() * sizeof(Element);
+    for (const Element & element : slots) {
+        if (element.is_used()) {
+            usage.owned_bytes += owned_bytes(element.get().value);
+        }
+        else if (element.is_empty()) {
+            usage.empty_bytes += sizeof(Element);
+        }
+        else {
+            usage.erased_bytes += sizeof(Element);
+        }
+    }
+    usage.payload_bytes = size * sizeof(Value);
+    usage.link_bytes = size * 2 * sizeof(std::size_t);
+    usage.padding_bytes = size * sizeof(Element) - usage.payload_bytes - usage.link_bytes;
+    return usage;
+}
+
+// slot-order scan filling the probe length and occupancy part of `TableStats`:
+// `probe_length(pos)` of the element at `pos`, `miss_length(pos)` of a lookup starting at `pos`
+template <class Element, class ProbeLength, class MissLength>
+TableStats scan_stats(const std::vector<Element> & slots, ProbeLength && probe_length, MissLength && miss_length)
+{
+    TableStats stats;
+    std::size_t used = 0;
+    std::size_t total_probes = 0;
+    std::size_t total_miss_probes = 0;
+    std::size_t cluster = 0;
+    for (std::size_t pos = 0; pos < slots.size(); ++pos) {
+        if (slots[pos].is_empty()) {
+            cluster = 0;
+        }
+        else {
+            stats.longest_cluster = std::max(stats.longest_cluster, ++cluster);
+        }
+        if (slots[pos].is_used()) {
+            const std::size_t probes = probe_length(pos);
+            if (stats.probe_lengths.size() < probes) {
+                stats.probe_lengths.resize(probes);
+            }
+            ++stats.probe_lengths[probes - 1];
+            total_probes += probes;
+            ++used;
+        }
+        else if (!slots[pos].is_empty()) {
+            ++stats.tombstones;
+        }
+        total_miss_probes += miss_length(pos);
+    }
+    // clusters wrapping around the end of the table
+    if (cluster != 0) {
+        for (std::size_t pos = 0; pos < slots.size() && !slots[pos].is_empty(); ++pos) {
+            stats.longest_cluster = std::min(std::max(stats.longest_cluster, ++cluster), slots.size());
+        }
+    }
+    stats.average_probe_length = used != 0 ? 1.0 * total_probes / used : 0;
+    stats.expected_miss_length = 1.0 * total_miss_probes / slots.size();
+    return stats;
+}
+
+// longest `probe_length(pos)` of the used slots
+template <class Element, class ProbeLength>
+std::size_t max_probe_length(const std::vector<Element> & slots, ProbeLength && probe_length)
+{
+    std::size_t result = 0;
+    for (std::size_t pos = 0; pos < slots.size(); ++pos) {
+        if (slots[pos].is_used()) {
+            result = std::max(result, probe_length(pos));
+        }
+    }
+    return result;
+}
+
+// position of the last element linked from `first`, `end` if there are none
+template <class Element>
+std::size_t last_linked(const std::vector<Element> & slots, const std::size_t first, const std::size_t end)
+{
+    std::size_t last = end;
+    for (std::size_t pos = first; pos != end; pos = slots[pos].get().next) {
+        last = pos;
+    }
+    return last;
+}
+
+// positions of the elements linked from `first` to `end`, the most frequently found first
+template <class Element>
+std::vector<std::size_t> by_hits(const std::vector<Element> & slots, const std::size_t first, const std::size_t end)
+{
+    std::vector<std::size_t> order;
+    for (std::size_t pos = first; pos != end; pos = slots[pos].get().next) {
+        order.push_back(pos);
+    }
+    std::stable_sort(order.begin(), order.end(), [&slots](const std::size_t lhs, const std::size_t rhs) {
+        return slots[lhs].get().hits() > slots[rhs].get().hits();
+    });
+    return order;
+}
+
+// rehash hook of a table, shared between its copies, which keeps tables without a hook small
+using SharedRehashHook = std::shared_ptr<const RehashHook>;
+
+inline SharedRehashHook share_hook(RehashHook hook)
+{
+    return hook ? std::make_shared<const RehashHook>(std::move(hook)) : nullptr;
+}
+
+// calls the hook, if any, on construction before a rehash and from `done()` after it
+class RehashNotification
+{
+public:
+    RehashNotification(const SharedRehashHook & hook,
+                       const std::size_t old_bucket_count,
+                       const std::size_t new_bucket_count,
+                       const std::size_t size)
+        : m_hook(hook.get())
+    {
+        if (m_hook != nullptr) {
+            m_event.old_bucket_count = old_bucket_count;
+            m_event.new_bucket_count = new_bucket_count;
+            m_event.size = size;
+            (*m_hook)(m_event);
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    void done()
+    {
+        if (m_hook != nullptr) {
+            m_event.phase = RehashEvent::Phase::After;
+            m_event.duration = std::chrono::steady_clock::now() - m_start;
+            (*m_hook)(m_event);
+        }
+    }
+
+private:
+    const RehashHook * m_hook;
+    RehashEvent m_event;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace table_details
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+namespace table_registry_details {
+inline std::string demangle(const char * name)
+{
+#if defined(__GNUG__)
+    int status = 0;
+    const std::unique_ptr<char, void (*)(void *)> demangled(abi::__cxa_demangle(name, nullptr, nullptr, &status), std::free);
+    if (status == 0) {
+        return demangled.get();
+    }
+#endif
+    return name;
+}
+} // namespace table_registry_details
+
+// State of a sampled table at the moment of `TableRegistry::snapshot()`
+struct TableSampleInfo
+{
+    std::string type; // container type, including all its policies
+    std::size_t capacity = 0;
+    std::size_t size = 0;
+    std::size_t max_probe_length = 0;
+    std::size_t tombstones = 0;
+    std::size_t rehashes = 0;
+};
+
+// Process-wide opt-in registry of `HashMap` / `HashSet` instances with the `RegistrySampling` policy:
+// when the sample rate N is not zero, every N-th constructed such table reports its state here.
+// The initial rate is taken from the HASH_TABLE_SAMPLE_RATE environment variable, 0 (disabled) by default.
+class TableRegistry
+{
+public:
+    struct Sample
+    {
+        const std::string type;
+        std::atomic<std::size_t> capacity{0};
+        std::atomic<std::size_t> size{0};
+        std::atomic<std::size_t> max_probe_length{0};
+        std::atomic<std::size_t> tombstones{0};
+        std::atomic<std::size_t> rehashes{0};
+
+        explicit Sample(std::string type_name) noexcept
+            : type(std::move(type_name))
+        {
+        }
+    };
+
+    // owned by a table, registers the table on construction if it is sampled and unregisters it on destruction
+    class Handle
+    {
+    public:
+        Handle() = default;
+
+        explicit Handle(const std::type_info & type)
+            : m_sample(TableRegistry::instance().try_sample(type))
+        {
+        }
+
+        Handle(const Handle &) = delete;
+        Handle & operator=(const Handle &) = delete;
+
+        Handle(Handle && other) noexcept
+            : m_sample(std::exchange(other.m_sample, nullptr))
+        {
+        }
+
+        Handle & operator=(Handle && other) noexcept
+        {
+            std::swap(m_sample, other.m_sample);
+            return *this;
+        }
+
+        ~Handle()
+        {
+            if (m_sample != nullptr) {
+                TableRegistry::instance().unregister(m_sample);
+            }
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return m_sample != nullptr;
+        }
+
+        void on_insert(const std::size_t size, const std::size_t probe_length, const bool reused_tombstone) const noexcept
+        {
+            m_sample->size.store(size, std::memory_order_relaxed);
+            if (probe_length > m_sample->max_probe_length.load(std::memory_order_relaxed)) {
+                m_sample->max_probe_length.store(probe_length, std::memory_order_relaxed);
+            }
+            if (reused_tombstone) {
+                m_sample->tombstones.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        void on_erase(const std::size_t size, const std::size_t erased) const noexcept
+        {
+            m_sample->size.store(size, std::memory_order_relaxed);
+            m_sample->tombstones.fetch_add(erased, std::memory_order_relaxed);
+        }
+
+        // the table was rebuilt from scratch (constructed, copied or rehashed)
+        void on_rebuild(const std::size_t size,
+                        const std::size_t capacity,
+                        const std::size_t rehashes,
+                        const std::size_t max_probe_length,
+                        const std::size_t tombstones) const noexcept
+        {
+            m_sample->size.store(size, std::memory_order_relaxed);
+            m_sample->capacity.store(capacity, std::memory_order_relaxed);
+            m_sample->rehashes.store(rehashes, std::memory_order_relaxed);
+            m_sample->max_probe_length.store(max_probe_length, std::memory_order_relaxed);
+            m_sample->tombstones.store(tombstones, std::memory_order_relaxed);
+        }
+
+    private:
+        Sample * m_sample = nullptr;
+    };
+
+    static TableRegistry & instance()
+    {
+        static TableRegistry registry;
+        return registry;
+    }
+
+    // every `rate`-th constructed table is sampled, 0 disables sampling
+    void set_sample_rate(const std::size_t rate) noexcept
+    {
+        m_rate.store(rate, std::memory_order_relaxed);
+    }
+
+    std::size_t sample_rate() const noexcept
+    {
+        return m_rate.load(std::memory_order_relaxed);
+    }
+
+    std::vector<TableSampleInfo> snapshot() const
+    {
+        std::vector<TableSampleInfo> result;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        result.reserve(m_samples.size());
+        for (const auto & sample : m_samples) {
+            TableSampleInfo & info = result.emplace_back();
+            info.type = sample->type;
+            info.capacity = sample->capacity.load(std::memory_order_relaxed);
+            info.size = sample->size.load(std::memory_order_relaxed);
+            info.max_probe_length = sample->max_probe_length.load(std::memory_order_relaxed);
+            info.tombstones = sample->tombstones.load(std::memory_order_relaxed);
+            info.rehashes = sample->rehashes.load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    void dump_text(std::ostream & out) const
+    {
+        for (const TableSampleInfo & info : snapshot()) {
+            out << info.type
+                << " capacity=" << info.capacity
+                << " size=" << info.size
+                << " max_probe_length=" << info.max_probe_length
+                << " tombstones=" << info.tombstones
+                << " rehashes=" << info.rehashes << '\n';
+        }
+    }
+
+    void dump_json(std::ostream & out) const
+    {
+        out << '[';
+        bool first = true;
+        for (const TableSampleInfo & info : snapshot()) {
+            out << (first ? "" : ",") << "\n  {\"type\": \"";
+            for (const char c : info.type) {
+                if (c == '"' || c == '\\') {
+                    out << '\\';
+                }
+                out << c;
+            }
+            out << "\", \"capacity\": " << info.capacity
+                << ", \"size\": " << info.size
+                << ", \"max_probe_length\": " << info.max_probe_length
+                << ", \"tombstones\": " << info.tombstones
+                << ", \"rehashes\": " << info.rehashes << '}';
+            first = false;
+        }
+        out << "\n]\n";
+    }
+
+    bool dump(const std::string & path, const bool json) const
+    {
+        std::ofstream out(path);
+        if (json) {
+            dump_json(out);
+        }
+        else {
+            dump_text(out);
+        }
+        return static_cast<bool>(out);
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<Sample>> m_samples;
+    std::atomic<std::size_t> m_rate;
+    std::atomic<std::size_t> m_constructed{0};
+
+    TableRegistry()
+        : m_rate(initial_rate())
+    {
+    }
+
+    static std::size_t initial_rate()
+    {
+        const char * rate = std::getenv("HASH_TABLE_SAMPLE_RATE");
+        return rate != nullptr ? std::strtoull(rate, nullptr, 10) : 0;
+    }
+
+    Sample * try_sample(const std::type_info & type)
+    {
+        const std::size_t rate = sample_rate();
+        if (rate == 0 || m_constructed.fetch_add(1, std::memory_order_relaxed) % rate != 0) {
+            return nullptr;
+        }
+        auto sample = std::make_unique<Sample>(table_registry_details::demangle(type.name()));
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_samples.emplace_back(std::move(sample)).get();
+    }
+
+    void unregister(const Sample * sample)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_samples.erase(std::find_if(m_samples.begin(), m_samples.end(), [sample](const auto & s) { return s.get() == sample; }));
+    }
+};
+
+// `SamplingPolicy` of `HashMap` / `HashSet` making the table a candidate for `TableRegistry`:
+// every N-th constructed or copied table with this policy is sampled. Tables with the default
+// `NoSampling` policy are not counted and pay nothing.
+//
+//     HashMap<int, int, LinearProbing, std::hash<int>, std::equal_to<int>, MaskRangeHashing,
+//             Power2RehashPolicy, NoAccessTracking, NoFilter, NoStats, RegistrySampling> map;
+class RegistrySampling
+{
+public:
+    static constexpr bool enabled = true;
+
+    explicit RegistrySampling(const std::type_info & type)
+        : m_type(&type)
+        , m_sample(type)
+    {
+    }
+
+    // a copy is a new table, sampled independently of the original
+    RegistrySampling(const RegistrySampling & other)
+        : RegistrySampling(*other.m_type)
+    {
+    }
+
+    RegistrySampling(RegistrySampling &&) noexcept = default;
+
+    RegistrySampling & operator=(const RegistrySampling & other)
+    {
+        return *this = RegistrySampling(other);
+    }
+
+    RegistrySampling & operator=(RegistrySampling &&) noexcept = default;
+
+    bool sampled() const noexcept
+    {
+        return static_cast<bool>(m_sample);
+    }
+
+    void on_insert(const std::size_t size, const std::size_t probe_length, const bool reused_tombstone) const noexcept
+    {
+        m_sample.on_insert(size, probe_length, reused_tombstone);
+    }
+
+    void on_erase(const std::size_t size, const std::size_t erased) const noexcept
+    {
+        m_sample.on_erase(size, erased);
+    }
+
+    void on_rebuild(const std::size_t size,
+                    const std::size_t capacity,
+                    const std::size_t rehashes,
+                    const std::size_t max_probe_length,
+                    const std::size_t tombstones) const noexcept
+    {
+        m_sample.on_rebuild(size, capacity, rehashes, max_probe_length, tombstones);
+    }
+
+private:
+    const std::type_info * m_type;
+    TableRegistry::Handle m_sample;
+};
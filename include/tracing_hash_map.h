@@ -0,0 +1,330 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Binary trace of table operations:
+//   header: 8 bytes magic "HMTRACE1", 1 byte flags
+//   record: 1 byte operation, 8 bytes key token, varint nanoseconds since the previous record
+// The key token is the key's hash value, and with `anonymize` (the default) it is additionally
+// mixed with a random salt which is not stored, so tokens keep key identity but not the key
+// (not a cryptographic guarantee). Reserve records carry the requested count instead of a token.
+enum class TraceOp : std::uint8_t
+{
+    Find,
+    Insert,
+    Erase,
+    Clear,
+    Reserve
+};
+
+struct TraceRecord
+{
+    TraceOp op;
+    std::uint64_t key;
+    std::uint64_t time_ns; // since the start of the trace
+};
+
+namespace trace_details {
+constexpr char magic[8] = {'H', 'M', 'T', 'R', 'A', 'C', 'E', '1'};
+constexpr std::uint8_t anonymized_flag = 1;
+
+inline std::uint64_t mix(std::uint64_t x) noexcept
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+} // namespace trace_details
+
+class TraceWriter
+{
+public:
+    explicit TraceWriter(const std::string & path, const bool anonymize = true)
+        : m_out(path, std::ios::binary | std::ios::trunc)
+        , m_salt(anonymize ? std::random_device{}() | (std::uint64_t{std::random_device{}()} << 32) : 0)
+        , m_anonymize(anonymize)
+        , m_start(std::chrono::steady_clock::now())
+    {
+        if (!m_out) {
+            throw std::runtime_error("TraceWriter: cannot open " + path);
+        }
+        m_out.write(trace_details::magic, sizeof(trace_details::magic));
+        m_out.put(static_cast<char>(anonymize ? trace_details::anonymized_flag : 0));
+    }
+
+    std::uint64_t token(const std::uint64_t hash) const noexcept
+    {
+        return m_anonymize ? trace_details::mix(hash ^ m_salt) : hash;
+    }
+
+    void write(const TraceOp op, const std::uint64_t key)
+    {
+        const auto now = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());
+        char buffer[1 + 8 + 10];
+        buffer[0] = static_cast<char>(op);
+        std::memcpy(buffer + 1, &key, 8);
+        std::size_t length = 9;
+        for (std::uint64_t delta = now - m_last; ; delta >>= 7) {
+            if (delta < 0x80) {
+                buffer[length++] = static_cast<char>(delta);
+                break;
+            }
+            buffer[length++] = static_cast<char>((delta & 0x7f) | 0x80);
+        }
+        m_out.write(buffer, length);
+        m_last = now;
+    }
+
+    void flush()
+    {
+        m_out.flush();
+    }
+
+private:
+    std::ofstream m_out;
+    const std::uint64_t m_salt;
+    const bool m_anonymize;
+    const std::chrono::steady_clock::time_point m_start;
+    std::uint64_t m_last = 0;
+};
+
+inline std::vector<TraceRecord> read_trace(const std::string & path, bool * anonymized = nullptr)
+{
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(trace_details::magic)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, trace_details::magic, sizeof(magic)) != 0) {
+        throw std::runtime_error("read_trace: " + path + " is not a trace");
+    }
+    const int flags = in.get();
+    if (flags == std::char_traits<char>::eof()) {
+        throw std::runtime_error("read_trace: " + path + " is truncated");
+    }
+    if (anonymized != nullptr) {
+        *anonymized = (flags & trace_details::anonymized_flag) != 0;
+    }
+
+    std::vector<TraceRecord> records;
+    std::uint64_t time = 0;
+    char head[9];
+    while (in.read(head, sizeof(head))) {
+        if (static_cast<std::uint8_t>(head[0]) > static_cast<std::uint8_t>(TraceOp::Reserve)) {
+            throw std::runtime_error("read_trace: " + path + " has an unknown operation");
+        }
+        TraceRecord record;
+        record.op = static_cast<TraceOp>(head[0]);
+        std::memcpy(&record.key, head + 1, 8);
+        std::uint64_t delta = 0;
+        for (unsigned shift = 0;; shift += 7) {
+            const int byte = in.get();
+            if (byte == std::char_traits<char>::eof() || shift > 63) {
+                throw std::runtime_error("read_trace: " + path + " is truncated");
+            }
+            delta |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+        time += delta;
+        record.time_ns = time;
+        records.push_back(record);
+    }
+    // a partial record head
+    if (in.gcount() != 0) {
+        throw std::runtime_error("read_trace: " + path + " is truncated");
+    }
+    return records;
+}
+
+// Re-executes a trace against `map`, keyed by the recorded tokens; returns the number of successful finds
+template <class Map>
+std::uint64_t replay_trace(Map & map, const std::vector<TraceRecord> & trace)
+{
+    std::uint64_t found = 0;
+    for (const TraceRecord & record : trace) {
+        switch (record.op) {
+        case TraceOp::Find:
+            found += map.count(record.key);
+            break;
+        case TraceOp::Insert:
+            map.try_emplace(record.key, record.time_ns);
+            break;
+        case TraceOp::Erase:
+            map.erase(record.key);
+            break;
+        case TraceOp::Clear:
+            map.clear();
+            break;
+        case TraceOp::Reserve:
+            map.reserve(record.key);
+            break;
+        }
+    }
+    return found;
+}
+
+// Opt-in wrapper around a `HashMap` recording every lookup and modification into a trace.
+// Iteration and element access through iterators are not recorded.
+template <class Map>
+class TracingHashMap
+{
+public:
+    using key_type = typename Map::key_type;
+    using mapped_type = typename Map::mapped_type;
+    using value_type = typename Map::value_type;
+    using size_type = typename Map::size_type;
+    using hasher = typename Map::hasher;
+    using iterator = typename Map::iterator;
+    using const_iterator = typename Map::const_iterator;
+
+    explicit TracingHashMap(const std::string & trace_path, const bool anonymize = true, Map map = Map())
+        : m_map(std::move(map))
+        , m_trace(trace_path, anonymize)
+    {
+    }
+
+    const Map & base() const noexcept
+    {
+        return m_map;
+    }
+
+    void flush()
+    {
+        m_trace.flush();
+    }
+
+    iterator begin() noexcept
+    {
+        return m_map.begin();
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return m_map.begin();
+    }
+
+    iterator end() noexcept
+    {
+        return m_map.end();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return m_map.end();
+    }
+
+    bool empty() const
+    {
+        return m_map.empty();
+    }
+
+    size_type size() const
+    {
+        return m_map.size();
+    }
+
+    void clear()
+    {
+        record(TraceOp::Clear, 0);
+        m_map.clear();
+    }
+
+    void reserve(const size_type count)
+    {
+        record(TraceOp::Reserve, count);
+        m_map.reserve(count);
+    }
+
+    std::pair<iterator, bool> insert(const value_type & value)
+    {
+        record_key(TraceOp::Insert, value.first);
+        return m_map.insert(value);
+    }
+
+    std::pair<iterator, bool> insert(value_type && value)
+    {
+        record_key(TraceOp::Insert, value.first);
+        return m_map.insert(std::move(value));
+    }
+
+    template <class... Args>
+    std::pair<iterator, bool> try_emplace(const key_type & key, Args &&... args)
+    {
+        record_key(TraceOp::Insert, key);
+        return m_map.try_emplace(key, std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    std::pair<iterator, bool> try_emplace(key_type && key, Args &&... args)
+    {
+        record_key(TraceOp::Insert, key);
+        return m_map.try_emplace(std::move(key), std::forward<Args>(args)...);
+    }
+
+    template <class M>
+    std::pair<iterator, bool> insert_or_assign(const key_type & key, M && value)
+    {
+        record_key(TraceOp::Insert, key);
+        return m_map.insert_or_assign(key, std::forward<M>(value));
+    }
+
+    mapped_type & operator[](const key_type & key)
+    {
+        record_key(TraceOp::Insert, key);
+        return m_map[key];
+    }
+
+    size_type erase(const key_type & key)
+    {
+        record_key(TraceOp::Erase, key);
+        return m_map.erase(key);
+    }
+
+    iterator find(const key_type & key)
+    {
+        record_key(TraceOp::Find, key);
+        return m_map.find(key);
+    }
+
+    const_iterator find(const key_type & key) const
+    {
+        record_key(TraceOp::Find, key);
+        return m_map.find(key);
+    }
+
+    size_type count(const key_type & key) const
+    {
+        record_key(TraceOp::Find, key);
+        return m_map.count(key);
+    }
+
+    bool contains(const key_type & key) const
+    {
+        record_key(TraceOp::Find, key);
+        return m_map.contains(key);
+    }
+
+private:
+    Map m_map;
+    mutable TraceWriter m_trace;
+
+    void record(const TraceOp op, const std::uint64_t key) const
+    {
+        m_trace.write(op, key);
+    }
+
+    void record_key(const TraceOp op, const key_type & key) const
+    {
+        record(op, m_trace.token(m_map.hash_function()(key)));
+    }
+};
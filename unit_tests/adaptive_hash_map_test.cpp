@@ -0,0 +1,212 @@
+#include "adaptive_hash_map.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// small thresholds, so that every representation is reached by small maps
+struct EagerMigrationPolicy
+{
+    static constexpr std::size_t inline_capacity = 4;
+
+    static constexpr bool to_inline(const std::size_t size) noexcept
+    {
+        return size <= 1;
+    }
+
+    static constexpr bool to_frozen(const std::size_t size, const std::size_t lookups_since_modification) noexcept
+    {
+        return size >= 16 && lookups_since_modification >= size;
+    }
+};
+
+// asks to go back to the inline array at sizes that do not fit into it
+struct OverreachingMigrationPolicy
+{
+    static constexpr std::size_t inline_capacity = 2;
+
+    static constexpr bool to_inline(std::size_t) noexcept
+    {
+        return true;
+    }
+
+    static constexpr bool to_frozen(std::size_t, std::size_t) noexcept
+    {
+        return false;
+    }
+};
+
+// moving assignment throws while `armed`
+struct ThrowingAssignment
+{
+    static inline bool armed = false;
+
+    int value = 0;
+
+    ThrowingAssignment(const int value)
+        : value(value)
+    {
+    }
+
+    ThrowingAssignment(const ThrowingAssignment &) = default;
+    ThrowingAssignment(ThrowingAssignment &&) = default;
+    ThrowingAssignment & operator=(const ThrowingAssignment &) = default;
+
+    ThrowingAssignment & operator=(ThrowingAssignment && other)
+    {
+        if (armed) {
+            throw std::runtime_error("ThrowingAssignment");
+        }
+        value = other.value;
+        return *this;
+    }
+};
+
+// collides every key with its neighbour, so that some key sets cannot be frozen
+struct PairHash
+{
+    std::size_t operator()(const int key) const noexcept
+    {
+        return static_cast<std::size_t>(key / 2);
+    }
+};
+
+using Map = AdaptiveHashMap<int, std::string, std::hash<int>, std::equal_to<int>, EagerMigrationPolicy>;
+
+template <class M>
+void expect_same(const M & map, const std::map<int, std::string> & expected)
+{
+    EXPECT_EQ(expected.size(), map.size());
+    std::map<int, std::string> contents;
+    map.for_each([&contents](const int key, const std::string & value) { contents.emplace(key, value); });
+    EXPECT_EQ(expected, contents);
+}
+
+} // anonymous namespace
+
+TEST(AdaptiveHashMapTest, RandomOperations)
+{
+    std::mt19937 rng(94);
+    Map map;
+    std::map<int, std::string> expected;
+    bool was_frozen = false;
+    for (int i = 0; i < 30000; ++i) {
+        const int key = static_cast<int>(rng() % (i % 2000 < 1000 ? 8 : 300));
+        switch (rng() % 6) {
+        case 0: {
+            const std::string value = std::to_string(i);
+            EXPECT_EQ(expected.emplace(key, value).second, map.try_emplace(key, value).second);
+            break;
+        }
+        case 1:
+            map.insert_or_assign(key, std::to_string(-i));
+            expected[key] = std::to_string(-i);
+            break;
+        case 2:
+            EXPECT_EQ(expected.erase(key), map.erase(key));
+            break;
+        case 3:
+            was_frozen |= i % 2 == 0 ? map.freeze() : map.freeze_if_read_mostly();
+            break;
+        default: {
+            const auto it = expected.find(key);
+            const std::string * value = map.find(key);
+            ASSERT_EQ(it != expected.end(), value != nullptr);
+            if (value != nullptr) {
+                EXPECT_EQ(it->second, *value);
+            }
+        }
+        }
+        EXPECT_EQ(expected.size(), map.size());
+    }
+    EXPECT_TRUE(was_frozen);
+    expect_same(map, expected);
+}
+
+TEST(AdaptiveHashMapTest, Representations)
+{
+    Map map;
+    EXPECT_EQ(Map::Representation::Inline, map.representation());
+    for (int key = 0; key < 32; ++key) {
+        map[key] = std::to_string(key);
+    }
+    EXPECT_EQ(Map::Representation::Table, map.representation());
+
+    // lookups never change the layout, pointers to values stay valid
+    const std::string * value = map.find(7);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_NE(nullptr, map.find(i % 32));
+    }
+    EXPECT_EQ(Map::Representation::Table, map.representation());
+    EXPECT_EQ(value, map.find(7));
+
+    EXPECT_TRUE(map.freeze_if_read_mostly());
+    EXPECT_EQ(Map::Representation::Frozen, map.representation());
+    EXPECT_EQ("7", map.at(7));
+    EXPECT_EQ(nullptr, map.find(100));
+
+    map[100] = "100";
+    EXPECT_EQ(Map::Representation::Table, map.representation());
+    EXPECT_FALSE(map.freeze_if_read_mostly());
+
+    for (int key = 0; key < 32; ++key) {
+        EXPECT_EQ(1, map.erase(key));
+    }
+    EXPECT_EQ(Map::Representation::Inline, map.representation());
+    EXPECT_EQ("100", map.at(100));
+}
+
+TEST(AdaptiveHashMapTest, FreezeFailureKeepsEntries)
+{
+    AdaptiveHashMap<int, int, PairHash> map;
+    for (int key = 0; key < 100; ++key) {
+        map[key] = -key;
+    }
+    EXPECT_FALSE(map.freeze());
+    EXPECT_FALSE(map.frozen());
+    EXPECT_EQ(100, map.size());
+    for (int key = 0; key < 100; ++key) {
+        EXPECT_EQ(-key, map.at(key));
+    }
+}
+
+TEST(AdaptiveHashMapTest, InlineOnlyWhenItFits)
+{
+    AdaptiveHashMap<int, int, std::hash<int>, std::equal_to<int>, OverreachingMigrationPolicy> map;
+    for (int key = 0; key < 10; ++key) {
+        map[key] = key;
+    }
+    for (int key = 0; key < 7; ++key) {
+        map.erase(key);
+        EXPECT_EQ(decltype(map)::Representation::Table, map.representation());
+    }
+    map.erase(7);
+    EXPECT_EQ(decltype(map)::Representation::Inline, map.representation());
+    EXPECT_EQ(8, map.at(8));
+    EXPECT_EQ(9, map.at(9));
+}
+
+TEST(AdaptiveHashMapTest, ThrowingInlineErase)
+{
+    AdaptiveHashMap<int, ThrowingAssignment> map;
+    for (int key = 0; key < 4; ++key) {
+        map.try_emplace(key, key);
+    }
+    ASSERT_EQ(decltype(map)::Representation::Inline, map.representation());
+    ThrowingAssignment::armed = true;
+    EXPECT_THROW(map.erase(0), std::runtime_error);
+    ThrowingAssignment::armed = false;
+    // every slot still holds a live entry
+    EXPECT_EQ(4, map.size());
+    std::size_t visited = 0;
+    map.for_each([&visited](int, const ThrowingAssignment &) { ++visited; });
+    EXPECT_EQ(4, visited);
+    EXPECT_EQ(1, map.erase(3));
+    EXPECT_EQ(3, map.size());
+}
@@ -0,0 +1,78 @@
+#include "bloom_filter.h"
+#include "hash_map.h"
+#include "hash_set.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+
+namespace {
+
+using FilteredMap = HashMap<std::uint64_t, int, LinearProbing, std::hash<std::uint64_t>, std::equal_to<std::uint64_t>, MaskRangeHashing, Power2RehashPolicy, NoAccessTracking, BlockedBloomFilter<>>;
+using FilteredSet = HashSet<std::uint64_t, QuadraticProbing, std::hash<std::uint64_t>, std::equal_to<std::uint64_t>, MaskRangeHashing, Power2RehashPolicy, NoAccessTracking, BlockedBloomFilter<8>>;
+
+} // anonymous namespace
+
+TEST(BloomFilterTest, NoFalseNegatives)
+{
+    BlockedBloomFilter<> filter;
+    filter.reset_filter(1 << 14);
+    EXPECT_EQ((1 << 14) * 4 / 8, filter.filter_bytes());
+    for (std::size_t hash = 0; hash < 4096; ++hash) {
+        filter.add_to_filter(hash);
+    }
+    std::size_t false_positives = 0;
+    for (std::size_t hash = 0; hash < 4096; ++hash) {
+        EXPECT_TRUE(filter.may_contain(hash));
+        false_positives += filter.may_contain(hash + 4096);
+    }
+    // 16 bits per key, 3 of them set
+    EXPECT_LT(false_positives, 4096 / 10);
+
+    filter.reset_filter(1 << 14);
+    EXPECT_FALSE(filter.may_contain(0));
+}
+
+TEST(BloomFilterTest, FilteredMapRandomOperations)
+{
+    FilteredMap map;
+    std::unordered_map<std::uint64_t, int> expected;
+    std::mt19937_64 rng(77);
+    for (int i = 0; i < 100000; ++i) {
+        const std::uint64_t key = rng() % 20000;
+        switch (rng() % 4) {
+        case 0:
+            EXPECT_EQ(expected.try_emplace(key, i).second, map.try_emplace(key, i).second);
+            break;
+        case 1:
+            EXPECT_EQ(expected.erase(key), map.erase(key));
+            break;
+        default: {
+            const auto it = expected.find(key);
+            const auto found = map.find(key);
+            ASSERT_EQ(it != expected.end(), found != map.end());
+            if (found != map.end()) {
+                EXPECT_EQ(it->second, found->second);
+            }
+        }
+        }
+        ASSERT_EQ(expected.size(), map.size());
+    }
+    EXPECT_GT(map.memory_usage().filter_bytes, 0);
+    map.clear();
+    EXPECT_FALSE(map.contains(expected.begin()->first));
+}
+
+TEST(BloomFilterTest, FilteredSetSurvivesRehash)
+{
+    FilteredSet set;
+    for (std::uint64_t key = 0; key < 10000; ++key) {
+        set.insert(key * 7);
+    }
+    set.rehash(set.bucket_count() * 4);
+    for (std::uint64_t key = 0; key < 70000; ++key) {
+        EXPECT_EQ(key % 7 == 0, set.contains(key));
+    }
+}
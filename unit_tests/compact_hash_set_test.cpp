@@ -0,0 +1,103 @@
+#include "compact_hash_set.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <set>
+#include <stdexcept>
+
+namespace {
+
+template <class Set>
+void expect_same(const Set & set, const std::set<std::uint64_t> & expected)
+{
+    EXPECT_EQ(expected.size(), set.size());
+    EXPECT_EQ(expected, std::set<std::uint64_t>(set.begin(), set.end()));
+    for (const auto key : expected) {
+        EXPECT_TRUE(set.contains(key));
+    }
+}
+
+// keys whose permuted hashes are `prefix` followed by `i`
+std::uint64_t key_with_hash(const std::uint64_t prefix, const std::uint64_t i)
+{
+    return compact_hash_set_details::restore(prefix | i);
+}
+
+} // anonymous namespace
+
+TEST(CompactHashSetTest, RandomOperations)
+{
+    std::mt19937_64 rng(78);
+    for (const std::uint64_t range : {std::uint64_t{1000}, ~std::uint64_t{0}}) {
+        CompactHashSet<std::uint64_t> set;
+        std::set<std::uint64_t> expected;
+        for (int i = 0; i < 50000; ++i) {
+            const std::uint64_t key = rng() % range;
+            switch (rng() % 4) {
+            case 0:
+            case 1:
+                EXPECT_EQ(expected.insert(key).second, set.insert(key));
+                break;
+            case 2:
+                EXPECT_EQ(expected.erase(key), set.erase(key));
+                break;
+            default:
+                EXPECT_EQ(expected.count(key), set.count(key));
+            }
+            if (i % 10000 == 0) {
+                set.reserve(3 * set.size());
+            }
+        }
+        expect_same(set, expected);
+    }
+}
+
+TEST(CompactHashSetTest, SmallKeys)
+{
+    CompactHashSet<std::int8_t> set;
+    for (int key = -128; key < 128; ++key) {
+        EXPECT_TRUE(set.insert(static_cast<std::int8_t>(key)));
+    }
+    EXPECT_EQ(256, set.size());
+    for (int key = -128; key < 128; ++key) {
+        EXPECT_TRUE(set.contains(static_cast<std::int8_t>(key)));
+    }
+}
+
+TEST(CompactHashSetTest, SharedPrefixGrowsTable)
+{
+    // hashes differ in their upper bits only, so they share home slots until the table is large enough
+    CompactHashSet<std::uint64_t> set;
+    std::set<std::uint64_t> expected;
+    for (std::uint64_t i = 0; i < 3000; ++i) {
+        const std::uint64_t key = key_with_hash(std::uint64_t{0xab} << 56, i << 44);
+        set.insert(key);
+        expected.insert(key);
+    }
+    expect_same(set, expected);
+}
+
+TEST(CompactHashSetTest, SharedPrefixTooLong)
+{
+    CompactHashSet<std::uint64_t> set;
+    std::set<std::uint64_t> expected;
+    std::uint64_t i = 0;
+    for (; i < 5000; ++i) {
+        const std::uint64_t key = key_with_hash(0x123456789abULL << 20, i);
+        try {
+            set.insert(key);
+        }
+        catch (const std::length_error &) {
+            break;
+        }
+        expected.insert(key);
+    }
+    ASSERT_LT(i, 5000);
+    // the set is left as it was before the failed insertion
+    expect_same(set, expected);
+    EXPECT_FALSE(set.contains(key_with_hash(0x123456789abULL << 20, i)));
+    EXPECT_TRUE(set.insert(1));
+    EXPECT_TRUE(set.contains(1));
+}
@@ -0,0 +1,136 @@
+#include "hash_aggregator.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+using Aggregator = HashAggregator<std::uint32_t, Count, Sum<std::int32_t, std::int64_t>, Min<std::int32_t>, Max<std::int32_t>>;
+using Result = Aggregator::result_type;
+using Reference = std::map<std::uint32_t, Result>;
+
+// sum rejecting negative values
+struct NonNegativeSum : Sum<std::int32_t, std::int64_t>
+{
+    static void update(std::int64_t & state, const std::int32_t value)
+    {
+        if (value < 0) {
+            throw std::invalid_argument("NonNegativeSum");
+        }
+        state += value;
+    }
+};
+
+struct Batch
+{
+    std::vector<std::uint32_t> keys;
+    std::vector<std::int32_t> values;
+};
+
+Batch random_batch(const std::size_t count, const std::uint32_t groups, const unsigned seed)
+{
+    std::mt19937 rng(seed);
+    Batch batch;
+    for (std::size_t i = 0; i < count; ++i) {
+        batch.keys.push_back(static_cast<std::uint32_t>(rng() % groups));
+        batch.values.push_back(static_cast<std::int32_t>(rng() % 2001) - 1000);
+    }
+    return batch;
+}
+
+void add(Reference & reference, const Batch & batch)
+{
+    for (std::size_t i = 0; i < batch.keys.size(); ++i) {
+        auto [it, inserted] = reference.try_emplace(batch.keys[i], Result{0, 0, batch.values[i], batch.values[i]});
+        auto & [count, sum, min, max] = it->second;
+        ++count;
+        sum += batch.values[i];
+        min = std::min(min, batch.values[i]);
+        max = std::max(max, batch.values[i]);
+    }
+}
+
+void consume(Aggregator & aggregator, const Batch & batch, const unsigned threads = 1)
+{
+    const std::int32_t * values = batch.values.data();
+    aggregator.consume_parallel(threads, batch.keys.data(), batch.keys.size(), nullptr, values, values, values);
+}
+
+void expect_same(const Reference & expected, const Aggregator & aggregator)
+{
+    ASSERT_EQ(expected.size(), aggregator.size());
+    Reference visited;
+    aggregator.for_each([&](const std::uint32_t key, const std::uint64_t count, const std::int64_t sum, const std::int32_t min, const std::int32_t max) {
+        EXPECT_TRUE(visited.try_emplace(key, Result{count, sum, min, max}).second);
+    });
+    EXPECT_EQ(expected, visited);
+}
+
+} // anonymous namespace
+
+TEST(HashAggregatorTest, MatchesReference)
+{
+    // the larger group count gets the table past the prefetching threshold
+    for (const std::uint32_t groups : {10u, 1000u, 100000u}) {
+        for (const unsigned threads : {1u, 4u}) {
+            Aggregator aggregator;
+            Reference expected;
+            for (unsigned batch_number = 0; batch_number < 3; ++batch_number) {
+                // not a multiple of the batch size
+                const Batch batch = random_batch(70001, groups, groups + threads * 10 + batch_number);
+                consume(aggregator, batch, threads);
+                add(expected, batch);
+            }
+            expect_same(expected, aggregator);
+            const auto & [key, result] = *expected.begin();
+            EXPECT_TRUE(aggregator.contains(key));
+            EXPECT_EQ(result, aggregator.result(key));
+        }
+    }
+}
+
+TEST(HashAggregatorTest, Merge)
+{
+    const Batch first = random_batch(5000, 300, 1);
+    const Batch second = random_batch(5000, 600, 2);
+    Aggregator lhs;
+    Aggregator rhs;
+    consume(lhs, first);
+    consume(rhs, second);
+    lhs.merge(rhs);
+    Reference expected;
+    add(expected, first);
+    add(expected, second);
+    expect_same(expected, lhs);
+
+    lhs.clear();
+    EXPECT_TRUE(lhs.empty());
+    EXPECT_FALSE(lhs.contains(first.keys[0]));
+    EXPECT_THROW(lhs.result(first.keys[0]), std::out_of_range);
+    lhs.consume(nullptr, 0, nullptr, nullptr, nullptr, nullptr);
+    EXPECT_TRUE(lhs.empty());
+}
+
+TEST(HashAggregatorTest, ParallelFailureLeavesAggregatorUnchanged)
+{
+    HashAggregator<std::uint32_t, Count, NonNegativeSum> aggregator;
+    const std::vector<std::uint32_t> keys(100000, 1);
+    std::vector<std::int32_t> values(keys.size(), 1);
+    aggregator.consume(keys.data(), 10, nullptr, values.data());
+
+    values[keys.size() - 1] = -1;
+    EXPECT_THROW(aggregator.consume_parallel(4, keys.data(), keys.size(), nullptr, values.data()), std::invalid_argument);
+    EXPECT_EQ(1, aggregator.size());
+    EXPECT_EQ(std::make_tuple(std::uint64_t{10}, std::int64_t{10}), aggregator.result(1));
+
+    values[keys.size() - 1] = 1;
+    aggregator.consume_parallel(4, keys.data(), keys.size(), nullptr, values.data());
+    EXPECT_EQ(std::make_tuple(std::uint64_t{100010}, std::int64_t{100010}), aggregator.result(1));
+}
@@ -0,0 +1,104 @@
+#include "hash_join.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Row
+{
+    std::uint64_t id;
+    std::string name;
+};
+
+std::vector<std::uint64_t> random_keys(const std::size_t count, const std::uint64_t range, const unsigned seed)
+{
+    std::mt19937_64 rng(seed);
+    std::vector<std::uint64_t> keys(count);
+    for (auto & key : keys) {
+        key = rng() % range;
+    }
+    return keys;
+}
+
+// nested loop join, in the order the hash join reports pairs: by probe row, then by build row
+JoinOutput nested_loop(const std::vector<std::uint64_t> & build, const std::vector<std::uint64_t> & probe, const JoinType type)
+{
+    JoinOutput out;
+    for (std::uint32_t p = 0; p < probe.size(); ++p) {
+        bool matched = false;
+        for (std::uint32_t b = 0; b < build.size(); ++b) {
+            if (build[b] == probe[p]) {
+                matched = true;
+                if (type == JoinType::Inner) {
+                    out.probe_rows.push_back(p);
+                    out.build_rows.push_back(b);
+                }
+            }
+        }
+        if ((type == JoinType::Semi && matched) || (type == JoinType::Anti && !matched)) {
+            out.probe_rows.push_back(p);
+        }
+    }
+    return out;
+}
+
+} // anonymous namespace
+
+TEST(HashJoinTest, MatchesNestedLoop)
+{
+    // batches of 7 leave a partial batch at the end of both sides
+    HashJoin<std::uint64_t, std::hash<std::uint64_t>, std::equal_to<std::uint64_t>, 7> join;
+    for (const unsigned seed : {1u, 2u, 3u}) {
+        const auto build = random_keys(1000 + seed, 400, seed);
+        const auto probe = random_keys(1500 + seed, 800, seed + 10);
+        join.build(build.data(), build.size());
+        EXPECT_EQ(build.size(), join.size());
+
+        for (const JoinType type : {JoinType::Inner, JoinType::Semi, JoinType::Anti}) {
+            const JoinOutput expected = nested_loop(build, probe, type);
+            JoinOutput out;
+            out.probe_rows.push_back(12345);
+            EXPECT_EQ(expected.size(), join.probe(probe.data(), probe.size(), type, out));
+            ASSERT_EQ(expected.size() + 1, out.size());
+            EXPECT_EQ(12345, out.probe_rows[0]);
+            EXPECT_EQ(expected.probe_rows, std::vector<std::uint32_t>(out.probe_rows.begin() + 1, out.probe_rows.end()));
+            EXPECT_EQ(expected.build_rows, out.build_rows);
+        }
+    }
+}
+
+TEST(HashJoinTest, Rows)
+{
+    const std::vector<Row> orders = {{1, "a"}, {2, "b"}, {1, "c"}, {3, "d"}, {1, "e"}};
+    const std::vector<Row> customers = {{1, "x"}, {4, "y"}, {3, "z"}};
+    const auto id = [](const Row & row) { return row.id; };
+
+    HashJoin<std::uint64_t> join;
+    join.build(orders.data(), orders.size(), id);
+    EXPECT_EQ(3, join.distinct_keys());
+    std::vector<std::uint32_t> matches;
+    join.for_each_match(1, [&](const std::uint32_t row) { matches.push_back(row); });
+    EXPECT_EQ((std::vector<std::uint32_t>{0, 2, 4}), matches);
+
+    JoinOutput out;
+    EXPECT_EQ(4, join.probe(customers.data(), customers.size(), id, JoinType::Inner, out));
+    EXPECT_EQ((std::vector<std::uint32_t>{0, 0, 0, 2}), out.probe_rows);
+    EXPECT_EQ((std::vector<std::uint32_t>{0, 2, 4, 3}), out.build_rows);
+    out.clear();
+    EXPECT_EQ(1, join.probe(customers.data(), customers.size(), id, JoinType::Anti, out));
+    EXPECT_EQ(std::vector<std::uint32_t>{1}, out.probe_rows);
+    EXPECT_TRUE(out.build_rows.empty());
+
+    // rebuilding replaces the build side
+    join.build(customers.data(), 1, id);
+    EXPECT_EQ(1, join.size());
+    out.clear();
+    EXPECT_EQ(3, join.probe(orders.data(), orders.size(), id, JoinType::Semi, out));
+    EXPECT_EQ((std::vector<std::uint32_t>{0, 2, 4}), out.probe_rows);
+}
@@ -0,0 +1,302 @@
+#include "hash_map.h"
+#include "hash_set.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <deque>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+// every key starts probing from slot 0, so the probe length of a key is its slot number + 1
+struct ConstantHash
+{
+    std::size_t operator()(int) const
+    {
+        return 0;
+    }
+};
+
+using TrackedMap = HashMap<int, int, LinearProbing, ConstantHash, std::equal_to<int>, MaskRangeHashing, Power2RehashPolicy, AccessTracking, NoFilter, CountingStats>;
+using TrackedSet = HashSet<int, LinearProbing, ConstantHash, std::equal_to<int>, MaskRangeHashing, Power2RehashPolicy, AccessTracking, NoFilter, CountingStats>;
+
+template <class Table>
+std::size_t probes_to_find(const Table & table, const int key)
+{
+    const std::size_t before = table.instrumentation().counters().probes;
+    EXPECT_TRUE(table.contains(key));
+    return table.instrumentation().counters().probes - before;
+}
+
+struct CounterDelta
+{
+    std::size_t lookups;
+    std::size_t probes;
+    std::size_t compares;
+    std::size_t tombstones_skipped;
+};
+
+// checks the counters changed by `operation` against `expected`
+template <class Table, class F>
+void expect_counted(Table & table, F && operation, const CounterDelta & expected)
+{
+    const CountingStats::Counters before = table.instrumentation().counters();
+    operation();
+    const CountingStats::Counters & after = table.instrumentation().counters();
+    EXPECT_EQ(expected.lookups, after.lookups - before.lookups);
+    EXPECT_EQ(expected.probes, after.probes - before.probes);
+    EXPECT_EQ(expected.compares, after.compares - before.compares);
+    EXPECT_EQ(expected.tombstones_skipped, after.tombstones_skipped - before.tombstones_skipped);
+}
+
+// rehashes seen by a hook, as (old bucket count, new bucket count, size) of the matching event pairs
+struct RehashLog
+{
+    std::vector<std::tuple<std::size_t, std::size_t, std::size_t>> rehashes;
+    std::size_t unmatched = 0;
+
+    RehashHook hook()
+    {
+        return [this](const RehashEvent & event) {
+            if (event.phase == RehashEvent::Phase::Before) {
+                rehashes.emplace_back(event.old_bucket_count, event.new_bucket_count, event.size);
+                ++unmatched;
+            }
+            else {
+                EXPECT_EQ(1, unmatched);
+                EXPECT_EQ(rehashes.back(), std::make_tuple(event.old_bucket_count, event.new_bucket_count, event.size));
+                --unmatched;
+            }
+        };
+    }
+};
+
+} // anonymous namespace
+
+TEST(HashMapTest, PromoteHot)
+{
+    TrackedMap map;
+    for (int key = 0; key < 20; ++key) {
+        map.emplace(key, key * 10);
+    }
+    EXPECT_EQ(20, probes_to_find(map, 19));
+    // 19 is the hottest key, then 17 and 18, the rest were never found
+    for (int i = 0; i < 10; ++i) {
+        map.find(19);
+    }
+    for (int i = 0; i < 5; ++i) {
+        map.find(17);
+    }
+    map.find(18);
+    const std::size_t bucket_count = map.bucket_count();
+
+    map.promote_hot();
+    EXPECT_EQ(bucket_count, map.bucket_count());
+    EXPECT_EQ(1, probes_to_find(map, 19));
+    EXPECT_EQ(2, probes_to_find(map, 17));
+    EXPECT_EQ(3, probes_to_find(map, 18));
+    ASSERT_EQ(20, map.size());
+    for (int key = 0; key < 20; ++key) {
+        EXPECT_EQ(key * 10, map.at(key));
+    }
+    EXPECT_FALSE(map.contains(20));
+
+    // hit counters start over: the lookups above make 0 the hottest key
+    for (int i = 0; i < 50; ++i) {
+        map.find(0);
+    }
+    map.promote_hot();
+    EXPECT_EQ(1, probes_to_find(map, 0));
+}
+
+TEST(HashMapTest, PromoteHotSet)
+{
+    TrackedSet set;
+    for (int key = 0; key < 10; ++key) {
+        set.insert(key);
+    }
+    set.erase(3);
+    set.find(9);
+    set.find(9);
+    set.find(8);
+    set.promote_hot();
+    EXPECT_EQ(1, probes_to_find(set, 9));
+    EXPECT_EQ(2, probes_to_find(set, 8));
+    EXPECT_EQ(9, set.size());
+    EXPECT_EQ(0, set.stats().tombstones);
+    for (int key = 0; key < 10; ++key) {
+        EXPECT_EQ(key != 3, set.contains(key));
+    }
+}
+
+TEST(HashMapTest, MemoryUsage)
+{
+    HashMap<int, std::string> map;
+    for (int key = 0; key < 100; ++key) {
+        map.emplace(key, std::string(100, 'x'));
+    }
+    for (int key = 0; key < 10; ++key) {
+        map.erase(key);
+    }
+    const MemoryUsage usage = map.memory_usage([](const std::pair<const int, std::string> & value) {
+        return value.second.capacity();
+    });
+    EXPECT_EQ(sizeof(map), usage.object_bytes);
+    EXPECT_EQ(0, usage.filter_bytes);
+    EXPECT_EQ(usage.slot_bytes * map.bucket_count(), usage.table_bytes);
+    EXPECT_EQ(usage.table_bytes, usage.payload_bytes + usage.link_bytes + usage.padding_bytes + usage.empty_bytes + usage.erased_bytes);
+    EXPECT_EQ(90 * sizeof(std::pair<const int, std::string>), usage.payload_bytes);
+    EXPECT_EQ(10 * usage.slot_bytes, usage.erased_bytes);
+    EXPECT_EQ((map.bucket_count() - 100) * usage.slot_bytes, usage.empty_bytes);
+    EXPECT_GE(usage.owned_bytes, 90 * 100);
+    EXPECT_EQ(usage.object_bytes + usage.table_bytes + usage.owned_bytes, usage.total_bytes());
+
+    HashSet<int> set{1, 2, 3};
+    const MemoryUsage set_usage = set.memory_usage();
+    EXPECT_EQ(set_usage.slot_bytes * set.bucket_count(), set_usage.table_bytes);
+    EXPECT_EQ(3 * sizeof(int), set_usage.payload_bytes);
+    EXPECT_EQ(0, set_usage.owned_bytes);
+}
+
+TEST(HashMapTest, Stats)
+{
+    // identity hash: keys below 64 sit in their own slot of the initial 64
+    HashMap<int, int> map;
+    for (const int key : {0, 1, 2, 10, 11, 63}) {
+        map[key] = key;
+    }
+    map[64] = 64;   // home slot 0, found in slot 3 with 4 probes
+    map[127] = 127; // home slot 63, wraps around to slot 4 with 6 probes
+    map.erase(11);
+    ASSERT_EQ(64, map.bucket_count());
+
+    const TableStats stats = map.stats();
+    EXPECT_EQ(7, stats.size);
+    EXPECT_EQ(64, stats.bucket_count);
+    EXPECT_EQ(1, stats.tombstones);
+    EXPECT_EQ(0, stats.rehashes);
+    EXPECT_FLOAT_EQ(7.0f / 64, stats.load_factor);
+    EXPECT_EQ((std::vector<std::size_t>{5, 0, 0, 1, 0, 1}), stats.probe_lengths);
+    EXPECT_EQ(6, stats.max_probe_length());
+    EXPECT_DOUBLE_EQ(15.0 / 7, stats.average_probe_length);
+    // slots 63 and 0 to 4
+    EXPECT_EQ(6, stats.longest_cluster);
+    // 7 + 6 + 5 + 4 + 3 + 2 probes from slots 63 and 0 to 4, 3 + 2 from 10 and 11, 1 from the 56 empty slots
+    EXPECT_DOUBLE_EQ(88.0 / 64, stats.expected_miss_length);
+
+    map.rehash(128);
+    EXPECT_EQ(1, map.stats().rehashes);
+    EXPECT_EQ(0, map.stats().tombstones);
+}
+
+TEST(HashMapTest, CountingStats)
+{
+    using CountedMap = HashMap<int, int, LinearProbing, std::hash<int>, std::equal_to<int>, MaskRangeHashing, Power2RehashPolicy, NoAccessTracking, NoFilter, CountingStats>;
+    CountedMap map;
+    const std::size_t slot_bytes = map.memory_usage().slot_bytes;
+    const CountingStats::Counters & counters = map.instrumentation().counters();
+    EXPECT_EQ(64 * slot_bytes, counters.allocated_bytes);
+
+    // identity hash: 0, 1 and 2 go to their home slots
+    expect_counted(
+            map,
+            [&] {
+                for (const int key : {0, 1, 2}) {
+                    map.emplace(key, key);
+                }
+            },
+            {3, 3, 0, 0});
+    EXPECT_EQ(3, counters.inserts);
+    expect_counted(map, [&] { map.find(1); }, {1, 1, 1, 0});
+    // home slot 0, compared with 0, 1 and 2, then stops at the empty slot 3
+    expect_counted(map, [&] { map.find(64); }, {1, 4, 3, 0});
+    expect_counted(map, [&] { map.erase(1); }, {1, 1, 1, 0});
+    expect_counted(map, [&] { map.find(64); }, {1, 4, 2, 1});
+    EXPECT_EQ(0, counters.rehashes);
+
+    map.rehash(128);
+    EXPECT_EQ(1, counters.rehashes);
+    EXPECT_EQ(5, counters.inserts);
+    EXPECT_EQ((64 + 128) * slot_bytes, counters.allocated_bytes);
+    EXPECT_GE(counters.rehash_time.count(), 0);
+    EXPECT_DOUBLE_EQ(13.0 / 7, counters.probes_per_lookup());
+}
+
+TEST(HashMapTest, RehashHook)
+{
+    using Rehash = std::tuple<std::size_t, std::size_t, std::size_t>;
+    RehashLog log;
+    HashMap<int, int> map;
+    map.set_rehash_hook(log.hook());
+    for (int key = 0; key < 33; ++key) {
+        map[key] = key;
+    }
+    EXPECT_EQ((std::vector<Rehash>{{64, 128, 32}}), log.rehashes);
+
+    // copies share the hook
+    HashMap<int, int> copy = map;
+    copy.rehash(1024);
+    EXPECT_EQ(Rehash(128, 1024, 33), log.rehashes.back());
+
+    // the hook goes with the contents on swap
+    HashMap<int, int> other;
+    other.swap(map);
+    map.rehash(256);
+    EXPECT_EQ(2, log.rehashes.size());
+    other.rehash(512);
+    EXPECT_EQ(Rehash(128, 512, 33), log.rehashes.back());
+
+    other.set_rehash_hook(nullptr);
+    other.rehash(2048);
+    EXPECT_EQ(3, log.rehashes.size());
+    EXPECT_EQ(0, log.unmatched);
+
+    HashSet<int> set;
+    set.set_rehash_hook(log.hook());
+    set.reserve(100);
+    EXPECT_EQ(Rehash(64, 256, 0), log.rehashes.back());
+}
+
+TEST(HashMapTest, EraseInsertChurn)
+{
+    // a constant size over many more operations than there are slots: without tombstones counting
+    // towards the load every free slot ends up erased, and misses never stop probing
+    HashMap<int, int> map;
+    HashSet<int> set;
+    std::deque<int> order; // iteration order, the newest key first
+    for (int key = 0; key < 100; ++key) {
+        map.emplace(key, key);
+        set.insert(key);
+        order.push_front(key);
+    }
+    const std::size_t bucket_count = map.bucket_count();
+    std::mt19937 rng(95);
+    for (int key = 100; key < 100000; ++key) {
+        const auto victim = order.begin() + rng() % order.size();
+        EXPECT_EQ(1, map.erase(*victim));
+        EXPECT_EQ(1, set.erase(*victim));
+        order.erase(victim);
+        map.emplace(key, key);
+        set.insert(key);
+        order.push_front(key);
+        ASSERT_EQ(100, map.size());
+        EXPECT_FALSE(map.contains(-key));
+        EXPECT_FALSE(set.contains(-key));
+    }
+    EXPECT_EQ(bucket_count, map.bucket_count());
+    EXPECT_EQ(bucket_count, set.bucket_count());
+    // tombstone clean-ups happened and kept the order
+    EXPECT_GT(map.stats().rehashes, 0);
+    const std::vector<int> expected(order.begin(), order.end());
+    std::vector<int> keys;
+    for (const auto & [key, value] : map) {
+        EXPECT_EQ(key, value);
+        keys.push_back(key);
+    }
+    EXPECT_EQ(expected, keys);
+    EXPECT_EQ(expected, std::vector<int>(set.begin(), set.end()));
+}
@@ -0,0 +1,103 @@
+#include "hybrid_int_set.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <set>
+
+namespace {
+
+using Set = HybridIntSet<std::uint32_t, 64>;
+
+void expect_same(const std::set<std::uint32_t> & expected, const Set & set)
+{
+    ASSERT_EQ(expected.size(), set.size());
+    std::set<std::uint32_t> visited;
+    set.for_each([&](const std::uint32_t key) {
+        EXPECT_TRUE(visited.insert(key).second);
+    });
+    EXPECT_EQ(expected, visited);
+}
+
+} // anonymous namespace
+
+TEST(HybridIntSetTest, RandomOperations)
+{
+    Set set;
+    std::set<std::uint32_t> expected;
+    std::mt19937 rng(79);
+    std::size_t max_dense = 0;
+    for (int i = 0; i < 200000; ++i) {
+        // three crowded blocks which cross the dense threshold both ways, plus sparse keys all over the range
+        const std::uint32_t key = rng() % 4 == 0 ? static_cast<std::uint32_t>(rng()) : (rng() % 3) << 16 | (rng() % 256);
+        switch (rng() % 5) {
+        case 0:
+        case 1:
+            EXPECT_EQ(expected.insert(key).second, set.insert(key));
+            break;
+        case 2:
+        case 3:
+            EXPECT_EQ(expected.erase(key), set.erase(key));
+            break;
+        default:
+            EXPECT_EQ(expected.count(key) != 0, set.contains(key));
+            EXPECT_EQ(expected.count(key), set.count(key));
+        }
+        ASSERT_EQ(expected.size(), set.size());
+        max_dense = std::max(max_dense, set.dense_block_count());
+        if (i % 20000 == 0) {
+            expect_same(expected, set);
+        }
+    }
+    EXPECT_GT(max_dense, 0);
+    expect_same(expected, set);
+}
+
+TEST(HybridIntSetTest, DenseBlockConversion)
+{
+    Set set;
+    for (std::uint32_t low = 0; low < 63; ++low) {
+        set.insert(5 << 16 | low);
+    }
+    EXPECT_EQ(0, set.dense_block_count());
+    set.insert(5 << 16 | 63);
+    EXPECT_EQ(1, set.dense_block_count());
+    EXPECT_FALSE(set.insert(5 << 16 | 10));
+    EXPECT_TRUE(set.contains(5 << 16 | 63));
+    EXPECT_FALSE(set.contains(5 << 16 | 64));
+    EXPECT_FALSE(set.contains(6 << 16 | 1));
+
+    // back to the hash set below half of the threshold
+    for (std::uint32_t low = 0; low < 32; ++low) {
+        EXPECT_EQ(1, set.erase(5 << 16 | low));
+    }
+    EXPECT_EQ(1, set.dense_block_count());
+    EXPECT_EQ(1, set.erase(5 << 16 | 32));
+    EXPECT_EQ(0, set.dense_block_count());
+    EXPECT_EQ(31, set.size());
+    EXPECT_TRUE(set.contains(5 << 16 | 40));
+    EXPECT_FALSE(set.contains(5 << 16 | 20));
+}
+
+TEST(HybridIntSetTest, Equality)
+{
+    Set dense;
+    Set sparse{1, 2, 3};
+    for (std::uint32_t key = 0; key < 100; ++key) {
+        dense.insert(key);
+    }
+    for (std::uint32_t key = 3; key < 100; ++key) {
+        dense.erase(key);
+    }
+    dense.insert(3);
+    dense.erase(0);
+    EXPECT_EQ(sparse, dense);
+    dense.insert(70000);
+    EXPECT_NE(sparse, dense);
+    dense.clear();
+    EXPECT_TRUE(dense.empty());
+    EXPECT_EQ(0, dense.dense_block_count());
+    EXPECT_FALSE(dense.contains(1));
+}
@@ -0,0 +1,134 @@
+#include "partitioned_hash_map.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// moving a value equal to `poison` throws while `armed`
+struct Fragile
+{
+    static inline bool armed = false;
+    static constexpr int poison = 13;
+
+    int value = 0;
+
+    Fragile() = default;
+
+    Fragile(const int value)
+        : value(value)
+    {
+    }
+
+    Fragile(const Fragile &) = default;
+
+    Fragile(Fragile && other)
+        : value(other.value)
+    {
+        if (armed && value == poison) {
+            throw std::runtime_error("Fragile");
+        }
+    }
+
+    Fragile & operator=(const Fragile &) = default;
+    Fragile & operator=(Fragile &&) = default;
+};
+
+std::vector<std::uint64_t> random_keys(const std::size_t count, const std::uint64_t range, const unsigned seed)
+{
+    std::mt19937_64 rng(seed);
+    std::vector<std::uint64_t> keys(count);
+    for (auto & key : keys) {
+        key = rng() % range;
+    }
+    return keys;
+}
+
+} // anonymous namespace
+
+TEST(PartitionedHashMapTest, BuildAndProbe)
+{
+    for (const unsigned threads : {1u, 4u}) {
+        // a small cache size forces many partitions
+        PartitionedHashMap<std::uint64_t, std::uint32_t> map(4096);
+        const auto keys = random_keys(100000, 60000, threads);
+        std::vector<std::uint32_t> values(keys.size());
+        std::unordered_map<std::uint64_t, std::uint32_t> expected;
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            values[i] = static_cast<std::uint32_t>(i);
+            expected.emplace(keys[i], values[i]);
+        }
+        map.build(keys.data(), values.data(), keys.size(), threads);
+        EXPECT_GT(map.partition_count(), 1);
+        EXPECT_EQ(expected.size(), map.size());
+
+        const auto probes = random_keys(50000, 120000, threads + 1);
+        std::vector<const std::uint32_t *> results(probes.size());
+        map.probe(probes.data(), probes.size(), results.data(), threads);
+        for (std::size_t i = 0; i < probes.size(); ++i) {
+            const auto it = expected.find(probes[i]);
+            ASSERT_EQ(it != expected.end(), results[i] != nullptr);
+            if (results[i] != nullptr) {
+                EXPECT_EQ(it->second, *results[i]);
+                EXPECT_EQ(results[i], map.find(probes[i]));
+            }
+        }
+
+        std::size_t visited = 0;
+        map.for_each([&](const std::uint64_t key, const std::uint32_t value) {
+            ++visited;
+            EXPECT_EQ(expected.at(key), value);
+        });
+        EXPECT_EQ(expected.size(), visited);
+    }
+}
+
+TEST(PartitionedHashMapTest, InsertAfterBuild)
+{
+    PartitionedHashMap<std::uint64_t, int> map(4096);
+    const auto keys = random_keys(10000, std::uint64_t{1} << 40, 98);
+    const std::uint64_t absent = std::uint64_t{1} << 41;
+    const std::vector<int> values(keys.size(), 1);
+    map.build(keys.data(), values.data(), keys.size());
+    const std::size_t size = map.size();
+    EXPECT_FALSE(map.try_emplace(keys[0], 2).second);
+    EXPECT_EQ(1, map.at(keys[0]));
+    EXPECT_TRUE(map.try_emplace(absent, 2).second);
+    EXPECT_EQ(size + 1, map.size());
+    EXPECT_EQ(2, map.at(absent));
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_FALSE(map.contains(keys[0]));
+    EXPECT_THROW(map.at(keys[0]), std::out_of_range);
+}
+
+TEST(PartitionedHashMapTest, FailedBuildKeepsContents)
+{
+    PartitionedHashMap<std::uint64_t, Fragile> map(4096);
+    const std::vector<std::uint64_t> small = {1, 2, 3};
+    const std::vector<Fragile> small_values = {10, 20, 30};
+    map.build(small.data(), small_values.data(), small.size());
+    const std::size_t partitions = map.partition_count();
+
+    std::vector<std::uint64_t> keys(50000);
+    std::vector<Fragile> values(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        keys[i] = i + 100;
+        values[i] = static_cast<int>(i % 1000);
+    }
+    Fragile::armed = true;
+    for (const unsigned threads : {1u, 4u}) {
+        EXPECT_THROW(map.build(keys.data(), values.data(), keys.size(), threads), std::runtime_error);
+        EXPECT_EQ(partitions, map.partition_count());
+        EXPECT_EQ(small.size(), map.size());
+        for (std::size_t i = 0; i < small.size(); ++i) {
+            EXPECT_EQ(small_values[i].value, map.at(small[i]).value);
+        }
+    }
+    Fragile::armed = false;
+}
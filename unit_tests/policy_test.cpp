@@ -0,0 +1,114 @@
+#include "hash_map.h"
+#include "hash_set.h"
+#include "policy.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using DenseMap = HashMap<int, int, QuadraticProbing, std::hash<int>, std::equal_to<int>, FibonacciRangeHashing, DynamicLoadFactorRehashPolicy>;
+using DenseSet = HashSet<int, LinearProbing, std::hash<int>, std::equal_to<int>, MaskRangeHashing, DynamicLoadFactorRehashPolicy>;
+using Gradual = GradualGrowthRehashPolicy<256>;
+using GradualMap = HashMap<int, int, LinearProbing, std::hash<int>, std::equal_to<int>, FastRangeHashing, Gradual>;
+
+template <class Map>
+void random_operations(Map & map, const unsigned seed)
+{
+    std::unordered_map<int, int> expected;
+    std::mt19937 rng(seed);
+    for (int i = 0; i < 50000; ++i) {
+        const int key = static_cast<int>(rng() % 10000);
+        switch (rng() % 3) {
+        case 0:
+            EXPECT_EQ(expected.try_emplace(key, i).second, map.try_emplace(key, i).second);
+            break;
+        case 1:
+            EXPECT_EQ(expected.erase(key), map.erase(key));
+            break;
+        default: {
+            const auto it = expected.find(key);
+            const auto found = map.find(key);
+            ASSERT_EQ(it != expected.end(), found != map.end());
+            if (found != map.end()) {
+                EXPECT_EQ(it->second, found->second);
+            }
+        }
+        }
+        ASSERT_EQ(expected.size(), map.size());
+        ASSERT_LE(map.load_factor(), map.max_load_factor());
+    }
+}
+
+} // anonymous namespace
+
+TEST(PolicyTest, DynamicLoadFactor)
+{
+    DynamicLoadFactorRehashPolicy policy;
+    EXPECT_FLOAT_EQ(0.5f, policy.max_load_factor());
+    EXPECT_THROW(policy.max_load_factor(0), std::invalid_argument);
+    EXPECT_THROW(policy.max_load_factor(1), std::invalid_argument);
+    EXPECT_THROW(policy.max_load_factor(-0.5f), std::invalid_argument);
+    EXPECT_FLOAT_EQ(0.5f, policy.max_load_factor());
+    policy.max_load_factor(0.8f);
+    EXPECT_FALSE(policy.need_rehash(80, 100));
+    EXPECT_TRUE(policy.need_rehash(81, 100));
+    EXPECT_EQ(125, policy.buckets_number(100));
+}
+
+TEST(PolicyTest, DynamicLoadFactorTables)
+{
+    for (const float ml : {0.5f, 0.75f, 0.9f}) {
+        DenseMap map;
+        map.max_load_factor(ml);
+        random_operations(map, static_cast<unsigned>(ml * 100));
+    }
+
+    DenseSet set;
+    set.max_load_factor(0.9f);
+    for (int key = 0; key < 900; ++key) {
+        set.insert(key);
+    }
+    EXPECT_EQ(1024, set.bucket_count());
+    EXPECT_THROW(set.max_load_factor(1.5f), std::invalid_argument);
+    // lowering the limit grows the table right away
+    set.max_load_factor(0.5f);
+    EXPECT_EQ(2048, set.bucket_count());
+    for (int key = 0; key < 1000; ++key) {
+        EXPECT_EQ(key < 900, set.contains(key));
+    }
+}
+
+TEST(PolicyTest, GradualGrowth)
+{
+    EXPECT_EQ(128, Gradual::new_size(100, 64));
+    EXPECT_EQ(256, Gradual::new_size(256, 64));
+    EXPECT_EQ(384, Gradual::new_size(300, 64));
+    EXPECT_EQ(576, Gradual::new_size(385, 384));
+    // reserve() gets the size it asks for
+    EXPECT_EQ(1000, Gradual::new_size(1000, 256));
+    EXPECT_EQ(512, Power2RehashPolicy::new_size(300, 64));
+}
+
+TEST(PolicyTest, GradualGrowthTables)
+{
+    GradualMap map;
+    std::vector<std::size_t> bucket_counts{map.bucket_count()};
+    for (int key = 0; key < 300; ++key) {
+        map[key] = key;
+        if (map.bucket_count() != bucket_counts.back()) {
+            bucket_counts.push_back(map.bucket_count());
+        }
+    }
+    EXPECT_EQ((std::vector<std::size_t>{64, 128, 256, 384, 576, 864}), bucket_counts);
+    for (int key = 0; key < 400; ++key) {
+        EXPECT_EQ(key < 300, map.contains(key));
+    }
+
+    GradualMap random;
+    random_operations(random, 96);
+}
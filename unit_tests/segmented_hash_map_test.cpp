@@ -0,0 +1,90 @@
+#include "segmented_hash_map.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+// every key shares one hash, no segment split can separate them
+struct ConstantHash
+{
+    std::size_t operator()(int) const
+    {
+        return 42;
+    }
+};
+
+template <class Map>
+void expect_same(const std::map<int, int> & expected, const Map & map)
+{
+    ASSERT_EQ(expected.size(), map.size());
+    std::map<int, int> visited;
+    map.for_each([&](const int key, const int value) {
+        EXPECT_TRUE(visited.emplace(key, value).second);
+    });
+    EXPECT_EQ(expected, visited);
+}
+
+} // anonymous namespace
+
+TEST(SegmentedHashMapTest, RandomOperations)
+{
+    SegmentedHashMap<int, int, std::hash<int>, std::equal_to<int>, 16> map;
+    std::map<int, int> expected;
+    std::mt19937 rng(97);
+    for (int i = 0; i < 100000; ++i) {
+        const int key = static_cast<int>(rng() % 5000);
+        switch (rng() % 6) {
+        case 0:
+        case 1:
+            EXPECT_EQ(expected.try_emplace(key, i).second, map.try_emplace(key, i).second);
+            break;
+        case 2:
+            expected[key] = i;
+            map.insert_or_assign(key, i);
+            break;
+        case 3:
+            EXPECT_EQ(expected.erase(key), map.erase(key));
+            break;
+        default: {
+            const auto it = expected.find(key);
+            const int * value = map.find(key);
+            ASSERT_EQ(it != expected.end(), value != nullptr);
+            if (value != nullptr) {
+                EXPECT_EQ(it->second, *value);
+            }
+        }
+        }
+        ASSERT_EQ(expected.size(), map.size());
+        if (i % 10000 == 0) {
+            expect_same(expected, map);
+        }
+    }
+    EXPECT_GT(map.segment_count(), 1);
+    EXPECT_GE(1u << map.global_depth(), map.segment_count());
+    expect_same(expected, map);
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(1, map.segment_count());
+    EXPECT_FALSE(map.contains(1));
+    EXPECT_THROW(map.at(1), std::out_of_range);
+}
+
+TEST(SegmentedHashMapTest, UnsplittableSegmentGrows)
+{
+    SegmentedHashMap<int, int, ConstantHash, std::equal_to<int>, 4> map;
+    std::map<int, int> expected;
+    for (int key = 0; key < 100; ++key) {
+        map[key] = key * 2;
+        expected[key] = key * 2;
+    }
+    EXPECT_EQ(1, map.segment_count());
+    EXPECT_FALSE(map.try_emplace(7, 0).second);
+    EXPECT_EQ(14, map.at(7));
+    expect_same(expected, map);
+}
@@ -0,0 +1,71 @@
+#include "hash_map.h"
+#include "hash_set.h"
+#include "table_registry.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+
+namespace {
+
+using SampledMap = HashMap<int, int, LinearProbing, std::hash<int>, std::equal_to<int>, MaskRangeHashing, Power2RehashPolicy, NoAccessTracking, NoFilter, NoStats, RegistrySampling>;
+using SampledSet = HashSet<int, LinearProbing, std::hash<int>, std::equal_to<int>, MaskRangeHashing, Power2RehashPolicy, NoAccessTracking, NoFilter, NoStats, RegistrySampling>;
+
+class TableRegistryTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        TableRegistry::instance().set_sample_rate(1);
+    }
+
+    void TearDown() override
+    {
+        TableRegistry::instance().set_sample_rate(0);
+    }
+};
+
+} // anonymous namespace
+
+TEST_F(TableRegistryTest, OnlySamplingPolicyRegisters)
+{
+    HashMap<int, int> plain{{1, 1}};
+    HashSet<int> plain_set{1};
+    EXPECT_TRUE(TableRegistry::instance().snapshot().empty());
+    EXPECT_LT(sizeof(plain), sizeof(SampledMap));
+}
+
+TEST_F(TableRegistryTest, SampledTables)
+{
+    {
+        SampledMap map;
+        for (int key = 0; key < 100; ++key) {
+            map[key] = key;
+        }
+        map.erase(5);
+        SampledSet set{1, 2, 3};
+
+        auto samples = TableRegistry::instance().snapshot();
+        ASSERT_EQ(2, samples.size());
+        const TableSampleInfo & info = samples[0];
+        EXPECT_EQ(0, info.type.find("HashMap<int, int"));
+        EXPECT_NE(std::string::npos, info.type.find("RegistrySampling"));
+        EXPECT_EQ(99, info.size);
+        EXPECT_EQ(map.bucket_count(), info.capacity);
+        EXPECT_EQ(1, info.tombstones);
+        EXPECT_EQ(map.stats().rehashes, info.rehashes);
+        EXPECT_EQ(map.stats().max_probe_length(), info.max_probe_length);
+        EXPECT_EQ(0, samples[1].type.find("HashSet<int"));
+
+        // copies are sampled on their own, moves take the sample over
+        SampledMap copy = map;
+        EXPECT_EQ(3, TableRegistry::instance().snapshot().size());
+        SampledMap moved = std::move(copy);
+        EXPECT_EQ(3, TableRegistry::instance().snapshot().size());
+        map.clear();
+        EXPECT_EQ(0, TableRegistry::instance().snapshot()[0].size);
+        EXPECT_EQ(0, TableRegistry::instance().snapshot()[0].tombstones);
+    }
+    EXPECT_TRUE(TableRegistry::instance().snapshot().empty());
+}
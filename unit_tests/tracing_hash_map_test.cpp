@@ -0,0 +1,137 @@
+#include "hash_map.h"
+#include "tracing_hash_map.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// trace file removed at the end of the test
+class TracingHashMapTest : public ::testing::Test
+{
+protected:
+    const std::string path = (std::filesystem::temp_directory_path() / (std::string("tracing_hash_map_test_") + ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".trace")).string();
+
+    void TearDown() override
+    {
+        std::remove(path.c_str());
+    }
+
+    void write_file(const std::string & bytes) const
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    void expect_error(const std::string & bytes, const std::string & message) const
+    {
+        write_file(bytes);
+        try {
+            read_trace(path);
+            ADD_FAILURE() << "no error, expected: " << message;
+        }
+        catch (const std::runtime_error & e) {
+            EXPECT_EQ("read_trace: " + path + " " + message, e.what());
+        }
+    }
+};
+
+const std::string header = std::string("HMTRACE1") + '\0';
+
+// a Find record of key 1 taking 1 ns
+std::string find_record()
+{
+    return std::string("\0\1\0\0\0\0\0\0\0\1", 10);
+}
+
+} // anonymous namespace
+
+TEST_F(TracingHashMapTest, RecordReadReplay)
+{
+    {
+        TracingHashMap<HashMap<int, int>> map(path, false);
+        map.reserve(100);
+        for (int key = 1; key <= 10; ++key) {
+            map.try_emplace(key, key);
+        }
+        EXPECT_NE(map.end(), map.find(3));
+        EXPECT_EQ(map.end(), map.find(42));
+        EXPECT_EQ(1, map.erase(5));
+        EXPECT_FALSE(map.contains(5));
+        map[11] = 11;
+        EXPECT_EQ(10, map.size());
+        map.clear();
+        map.insert({7, 7});
+        EXPECT_EQ(1, map.count(7));
+    }
+
+    bool anonymized = true;
+    const std::vector<TraceRecord> trace = read_trace(path, &anonymized);
+    EXPECT_FALSE(anonymized);
+    const std::vector<std::pair<TraceOp, std::uint64_t>> expected = {
+            {TraceOp::Reserve, 100}, {TraceOp::Insert, 1}, {TraceOp::Insert, 2}, {TraceOp::Insert, 3},
+            {TraceOp::Insert, 4}, {TraceOp::Insert, 5}, {TraceOp::Insert, 6}, {TraceOp::Insert, 7},
+            {TraceOp::Insert, 8}, {TraceOp::Insert, 9}, {TraceOp::Insert, 10}, {TraceOp::Find, 3},
+            {TraceOp::Find, 42}, {TraceOp::Erase, 5}, {TraceOp::Find, 5}, {TraceOp::Insert, 11},
+            {TraceOp::Clear, 0}, {TraceOp::Insert, 7}, {TraceOp::Find, 7}};
+    ASSERT_EQ(expected.size(), trace.size());
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        // without anonymization the tokens are the std::hash values, the keys themselves
+        EXPECT_EQ(expected[i].first, trace[i].op);
+        EXPECT_EQ(expected[i].second, trace[i].key);
+        if (i != 0) {
+            EXPECT_LE(trace[i - 1].time_ns, trace[i].time_ns);
+        }
+    }
+
+    HashMap<std::uint64_t, std::uint64_t> replayed;
+    EXPECT_EQ(2, replay_trace(replayed, trace));
+    EXPECT_EQ(1, replayed.size());
+    EXPECT_TRUE(replayed.contains(7));
+}
+
+TEST_F(TracingHashMapTest, Anonymized)
+{
+    {
+        TracingHashMap<HashMap<int, int>> map(path);
+        map.try_emplace(123, 1);
+        map.find(123);
+        map.find(456);
+    }
+    bool anonymized = false;
+    const std::vector<TraceRecord> trace = read_trace(path, &anonymized);
+    EXPECT_TRUE(anonymized);
+    ASSERT_EQ(3, trace.size());
+    EXPECT_EQ(trace[0].key, trace[1].key);
+    EXPECT_NE(trace[1].key, trace[2].key);
+    EXPECT_NE(123, trace[0].key);
+    HashMap<std::uint64_t, std::uint64_t> replayed;
+    EXPECT_EQ(1, replay_trace(replayed, trace));
+}
+
+TEST_F(TracingHashMapTest, MalformedTraces)
+{
+    write_file(header + find_record());
+    EXPECT_EQ(1, read_trace(path).size());
+
+    expect_error("HMTRACE2" + find_record(), "is not a trace");
+    expect_error("HMTR", "is not a trace");
+    // no flags byte
+    expect_error("HMTRACE1", "is truncated");
+    // partial record heads
+    expect_error(header + find_record().substr(0, 1), "is truncated");
+    expect_error(header + find_record() + find_record().substr(0, 8), "is truncated");
+    // the varint of the time is missing or cut short
+    expect_error(header + find_record().substr(0, 9), "is truncated");
+    expect_error(header + find_record().substr(0, 9) + '\x80', "is truncated");
+    expect_error(header + std::string(9, '\0') + std::string(10, '\xff') + '\1', "is truncated");
+    // past TraceOp::Reserve
+    expect_error(header + find_record() + '\5' + find_record().substr(1), "has an unknown operation");
+}